@@ -1,8 +1,13 @@
 #include <iostream>
 #include <typeinfo>
+#include <chrono>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <stdexcept>
 
 // Testing in terminal:
-// g++ -o main -std=c++11 -Wall -Wextra -pedantic main.cpp && ./main
+// g++ -o main -std=c++11 -O2 -Wall -Wextra -pedantic main.cpp && ./main
 // g++ -v | Apple LLVM version 8.1.0 (clang-802.0.42)
 
 // ================================================================================================================
@@ -49,6 +54,27 @@ private:
 	value_type n;
 };
 
+// The same number without virtual methods, and therefore without a vptr.
+//
+// The mixins below call BASE::set and BASE::get qualified, which is always a static call.
+// Whether a stack like Redoable<Undoable<...>> is virtual or not is only decided by the class
+// at the bottom: on top of Number every set is virtual, on top of StaticNumber every set is
+// statically bound and can be inlined all the way down - with the very same mixins.
+// Code working with any stack then takes it as a template parameter instead of a Number &.
+class StaticNumber {
+public:
+	typedef int value_type;
+
+	StaticNumber() : n(0) {}
+	StaticNumber(value_type n) : n(n) {}
+
+	void set(value_type n) { this->n = n; }
+	value_type get() const { return n; }
+
+private:
+	value_type n;
+};
+
 // This class represents the concept of something undoable. A value can be set an reverted for one step.
 //
 // Note the template parameter, meaning that this concept can build upon
@@ -69,7 +95,9 @@ public:
 	// https://stackoverflow.com/questions/347358/inheriting-constructors
 	using BASE::BASE;
 
-	virtual void set(value_type n) override {
+	// no virtual / override here: if BASE::set is virtual, this set overrides it anyway,
+	// if it is not (StaticNumber), the mixin doesn't make it virtual either
+	void set(value_type n) {
 		before = BASE::get();
 		BASE::set(n); 
 	}
@@ -91,7 +119,7 @@ public:
 	// https://stackoverflow.com/questions/347358/inheriting-constructors
 	using BASE::BASE;
 
-	virtual void set(value_type n) override {
+	void set(value_type n) {
 		after = n;
 		BASE::set(n); 
 	}
@@ -101,6 +129,280 @@ private:
 	value_type after;
 };
 
+// Undoable and Redoable only remember one step each, and stacked they don't even agree on it
+// (redo just goes back to the last value set, not to what undo reverted).
+// History is the real thing: any number of steps back and forth, bounded by CAPACITY.
+//
+// The steps live in a ring buffer inside the object, so set() never allocates, and when the
+// buffer is full the oldest step is dropped. undo() and redo() are O(1). A set() after some
+// undo()s throws away the steps which could have been redone, like every editor does.
+//
+// How a step is remembered is up to STEPS: whole values (Snapshots, the default) or only the
+// difference between two values (Deltas), which pays off for large value_types. History keeps
+// one STEPS object, so a policy may hold some storage of its own:
+//
+//	step_type
+//	bool record(before, after, step &)          false if there is no room for it right now
+//	T undo(current, step &) / redo(current, step &)
+//	void forget(step &)                         the step is dropped, release what it holds
+template <typename T>
+struct Snapshots {
+	typedef T step_type;
+
+	// keeps the value before the step ...
+	bool record(const T &before, const T &, step_type &step) {
+		step = before;
+		return true;
+	}
+
+	// ... and swaps it with the current value on undo, so the same slot holds the value after
+	// the step for redo - and the other way around
+	T undo(const T &current, step_type &step) {
+		T value = step;
+		step = current;
+		return value;
+	}
+	T redo(const T &current, step_type &step) { return undo(current, step); }
+
+	void forget(step_type &) {}
+};
+
+// What a delta is depends on the type, so it is looked up in DeltaTraits<T>:
+//
+//	delta_type                                  small description of a change
+//	static bool diff(before, after, delta &)    false if the change doesn't fit into a delta
+//	static T apply(value, delta)                after from before
+//	static T revert(value, delta)               before from after
+//
+// For a large value_type (say a document), specialize it so delta_type holds just the edited part.
+template <typename T, typename = void>
+struct DeltaTraits;
+
+// integers: xor-ing the difference in and out
+template <typename T>
+struct DeltaTraits<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+	typedef T delta_type;
+
+	static bool diff(T before, T after, delta_type &delta) {
+		delta = before ^ after;
+		return true;
+	}
+	static T apply(T value, delta_type delta) { return value ^ delta; }
+	static T revert(T value, delta_type delta) { return value ^ delta; }
+};
+
+// std::array: a step keeps only the range of elements it changed, xor-ed like the integers.
+// The range has to fit into a window of 8 elements - enough for editing a field or two.
+// Wider changes are left to the snapshots of Deltas.
+template <typename T, std::size_t N>
+struct DeltaTraits<std::array<T, N>> {
+	static_assert(std::is_integral<T>::value, "the changed elements are xor-ed");
+	static const std::size_t window = 8;
+
+	struct delta_type {
+		std::size_t first = 0;
+		std::size_t count = 0;
+		std::array<T, window> bits = {{}};
+	};
+
+	static bool diff(const std::array<T, N> &before, const std::array<T, N> &after, delta_type &delta) {
+		std::size_t first = 0, last = N;
+		while (first < N && before[first] == after[first]) { first++; }
+		while (last > first && before[last - 1] == after[last - 1]) { last--; }
+		if (last - first > window) { return false; }
+
+		delta.first = first;
+		delta.count = last - first;
+		for (std::size_t k = 0; k < delta.count; k++) { delta.bits[k] = before[first + k] ^ after[first + k]; }
+		return true;
+	}
+
+	static std::array<T, N> apply(std::array<T, N> value, const delta_type &delta) {
+		for (std::size_t k = 0; k < delta.count; k++) { value[delta.first + k] ^= delta.bits[k]; }
+		return value;
+	}
+	static std::array<T, N> revert(const std::array<T, N> &value, const delta_type &delta) { return apply(value, delta); }
+};
+
+// Steps as deltas where they fit, and as whole values where they don't. There are only
+// SNAPSHOTS slots for whole values (that is the saving); when they are taken, record() fails
+// and History drops its oldest steps until one is free again.
+template <typename T, std::size_t SNAPSHOTS = 2>
+class Deltas {
+	static_assert(SNAPSHOTS > 0, "wide changes need at least one snapshot slot");
+	typedef DeltaTraits<T> traits;
+
+public:
+	struct step_type {
+		typename traits::delta_type delta;
+		int snapshot = -1; // slot of the whole value before the step, -1 for a delta
+	};
+
+	bool record(const T &before, const T &after, step_type &step) {
+		step.snapshot = -1;
+		if (traits::diff(before, after, step.delta)) { return true; }
+
+		for (std::size_t s = 0; s < SNAPSHOTS; s++) {
+			if (!used[s]) {
+				used[s] = true;
+				snapshots[s] = before;
+				step.snapshot = s;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// a snapshot is swapped with the current value, just like Snapshots does
+	T undo(const T &current, step_type &step) {
+		if (step.snapshot < 0) { return traits::revert(current, step.delta); }
+		T value = snapshots[step.snapshot];
+		snapshots[step.snapshot] = current;
+		return value;
+	}
+
+	T redo(const T &current, step_type &step) {
+		if (step.snapshot < 0) { return traits::apply(current, step.delta); }
+		return undo(current, step);
+	}
+
+	void forget(step_type &step) {
+		if (step.snapshot >= 0) { used[step.snapshot] = false; }
+		step.snapshot = -1;
+	}
+
+private:
+	std::array<T, SNAPSHOTS> snapshots;
+	std::array<bool, SNAPSHOTS> used = {{}};
+};
+
+template <typename BASE, std::size_t CAPACITY = 16,
+		typename STEPS = Snapshots<typename BASE::value_type>,
+		typename value_type = typename BASE::value_type>
+class History : public BASE {
+	static_assert(CAPACITY > 0, "a history needs room for at least one step");
+
+public:
+	using BASE::BASE;
+
+	void set(value_type n) {
+		// a new write makes the undone steps unreachable
+		while (count > done) { policy.forget(steps[slot(--count)]); }
+		if (count == CAPACITY) { dropOldest(); }
+
+		// the policy may run out of room for this step, older steps make room then
+		typename STEPS::step_type step;
+		while (!policy.record(BASE::get(), n, step)) {
+			if (count == 0) { throw std::logic_error("the history policy has no room for a single step"); }
+			dropOldest();
+		}
+
+		steps[slot(count)] = step;
+		done = ++count;
+		BASE::set(n);
+	}
+
+	// both return false if there is no step left to undo / redo
+	bool undo() {
+		if (done == 0) { return false; }
+		done--;
+		BASE::set(policy.undo(BASE::get(), steps[slot(done)]));
+		return true;
+	}
+
+	bool redo() {
+		if (done == count) { return false; }
+		BASE::set(policy.redo(BASE::get(), steps[slot(done)]));
+		done++;
+		return true;
+	}
+
+	std::size_t undoable() const { return done; }
+	std::size_t redoable() const { return count - done; }
+
+private:
+	std::size_t slot(std::size_t step) const { return (oldest + step) % CAPACITY; }
+
+	// only called when nothing is undone, i.e. done == count
+	void dropOldest() {
+		policy.forget(steps[oldest]);
+		oldest = (oldest + 1) % CAPACITY;
+		count--;
+		done--;
+	}
+
+	STEPS policy;
+	std::array<typename STEPS::step_type, CAPACITY> steps;
+	std::size_t oldest = 0; // slot of the first step still remembered
+	std::size_t count = 0;  // steps remembered
+	std::size_t done = 0;   // of those, the ones not undone
+};
+
+// A base with a large value_type (256 ints), where Deltas pays off.
+class Cells {
+public:
+	typedef std::array<int, 256> value_type;
+
+	Cells() : cells() {}
+
+	void set(value_type cells) { this->cells = cells; }
+	value_type get() const { return cells; }
+
+private:
+	value_type cells;
+};
+
+// [BENCHMARK] ===================
+// The same loop once through a Number & (virtual calls down the stack) and once on the
+// static stack (set / get inlined into the loop).
+//
+// Both loops are noinline (gcc / clang), so the only difference is virtual against static
+// set / get: the compiler can't see which object is behind the Number &, as it would be in
+// real code - otherwise it would devirtualize the calls on its own - and neither loop gets
+// optimized into benchmark_stacks.
+__attribute__((noinline)) long churn(Number &n, int count) {
+	long sum = 0;
+	for (int i = 0; i < count; i++) {
+		n.set(i);
+		sum += n.get();
+	}
+	return sum;
+}
+
+template <typename NUMBER>
+__attribute__((noinline)) long churn(NUMBER &n, int count) {
+	long sum = 0;
+	for (int i = 0; i < count; i++) {
+		n.set(i);
+		sum += n.get();
+	}
+	return sum;
+}
+
+void benchmark_stacks(int count) {
+	typedef std::chrono::steady_clock Clock;
+
+	Redoable<Undoable<Number>> virtual_number(0);
+	Number &number = virtual_number;
+
+	Clock::time_point start = Clock::now();
+	long virtual_sum = churn(number, count);
+	double virtual_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	Redoable<Undoable<StaticNumber>> static_number(0);
+
+	start = Clock::now();
+	long static_sum = churn(static_number, count);
+	double static_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::cout << count << " x set/get" << std::endl;
+	std::cout << "Redoable<Undoable<Number>>:       " << virtual_ms << " ms (sum " << virtual_sum << ", "
+	          << sizeof(virtual_number) << " bytes)" << std::endl;
+	std::cout << "Redoable<Undoable<StaticNumber>>: " << static_ms << " ms (sum " << static_sum << ", "
+	          << sizeof(static_number) << " bytes)" << std::endl;
+}
+// ===================
+
 int main() {
 	// create a number which can only be undone
 	Undoable<Number> n(0);
@@ -139,4 +441,76 @@ int main() {
 	std::cout << number.get() << std::endl;
 	number.redo();
 	std::cout << number.get() << std::endl;
+
+	// exactly the same composition, but statically bound
+	Redoable<Undoable<StaticNumber>> fast(9999);
+	fast.set(10000);
+	fast.undo();
+	std::cout << fast.get() << std::endl;
+	fast.redo();
+	std::cout << fast.get() << std::endl;
+
+	std::cout << std::endl;
+
+	// any number of steps, at most 3 remembered
+	History<Number, 3> history(0);
+	for (int i = 1; i <= 5; i++) { history.set(i * 10); }
+
+	// 50 -> 40 -> 30 -> 20, then 10 is forgotten
+	while (history.undo()) { std::cout << history.get() << " "; }
+	std::cout << "(undo)" << std::endl;
+
+	history.redo();
+	history.redo();
+	std::cout << history.get() << " (redo twice)" << std::endl;
+
+	// a new value ends the redo
+	history.set(99);
+	std::cout << history.get() << ", redoable: " << history.redoable() << std::endl;
+	history.undo();
+	std::cout << history.get() << " (undo)" << std::endl;
+
+	// the same history, remembering differences only, on top of the static number
+	History<StaticNumber, 3, Deltas<int>> deltas(7);
+	deltas.set(1000);
+	deltas.set(-5);
+	deltas.undo();
+	deltas.undo();
+	std::cout << deltas.get() << " (undo twice)" << std::endl;
+	deltas.redo();
+	std::cout << deltas.get() << " (redo)" << std::endl;
+
+	// a large value: a snapshot step holds all 256 cells, a delta step just the changed ones
+	History<Cells, 8> snapshots;
+	History<Cells, 8, Deltas<Cells::value_type>> patches;
+	Cells::value_type cells = patches.get();
+	for (int i = 1; i <= 4; i++) {
+		cells[i * 10] = i;
+		snapshots.set(cells);
+		patches.set(cells);
+	}
+	patches.undo();
+	patches.undo();
+	patches.redo();
+	std::cout << "cells[20], [30], [40]: " << patches.get()[20] << ", " << patches.get()[30] << ", "
+	          << patches.get()[40] << " (undo twice, redo)" << std::endl;
+
+	// edits far apart and a rewrite of all cells don't fit into a delta, they take a snapshot slot
+	cells[0] = 100;
+	cells[200] = 200;
+	patches.set(cells);
+	cells.fill(7);
+	patches.set(cells);
+	std::cout << "cells[0], [200]: " << patches.get()[0] << ", " << patches.get()[200] << " (wide changes)" << std::endl;
+	patches.undo();
+	std::cout << "cells[0], [200]: " << patches.get()[0] << ", " << patches.get()[200] << " (undo)" << std::endl;
+	patches.undo();
+	std::cout << "cells[0], [200], [30]: " << patches.get()[0] << ", " << patches.get()[200] << ", "
+	          << patches.get()[30] << " (undo)" << std::endl;
+
+	std::cout << "sizeof: " << sizeof(snapshots) << " bytes with snapshots, "
+	          << sizeof(patches) << " bytes with deltas (and 2 snapshot slots)" << std::endl;
+
+	std::cout << std::endl;
+	benchmark_stacks(100000000);
 }
\ No newline at end of file
@@ -1,8 +1,20 @@
 #include <iostream>
 #include <typeinfo>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <utility>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <cstdlib>
+#include <cxxabi.h>
 
 // Testing in terminal:
-// g++ -o main -std=c++11 -Wall -Wextra -pedantic main.cpp && ./main
+// g++ -o main -std=c++14 -Wall -Wextra -pedantic main.cpp && ./main
 // g++ -v | Apple LLVM version 8.1.0 (clang-802.0.42)
 
 // ================================================================================================================
@@ -25,10 +37,74 @@ Late binding / dynamic binding / dynamic dispatch in C++
     https://en.wikipedia.org/wiki/Late_binding#Late_binding_in_C.2B.2B
 */
 
+// [TYPE IDS] ===================
+// typeid(*this).name() builds a new std::string with the mangled name on every call,
+// just to find out what an object is. Instead, every class gets a small, dense integer id
+// (0, 1, 2, ...) the first time class_id<T>() is used. The id never changes afterwards,
+// so checking a type is an integer compare, and the ids can index into tables directly.
+//
+// The (demangled) name of every class is interned once, type_name(id) hands out a
+// reference to it - only needed for diagnostics.
+class TypeRegistry {
+public:
+    static const int max_types = 1024;
+
+    static int add(const char *mangled) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+
+        int id = r.names.size();
+        if (id >= max_types) { throw std::length_error("too many registered types"); }
+
+        r.names.push_back(demangle(mangled));
+        r.published[id].store(&r.names.back(), std::memory_order_release);
+        return id;
+    }
+
+    // lock-free, the name of an id never changes once it is published
+    static const std::string &name(int id) { return *registry().published[id].load(std::memory_order_acquire); }
+
+private:
+    struct Registry {
+        std::mutex lock;
+        std::deque<std::string> names; // a deque never moves its elements
+        std::atomic<const std::string *> published[max_types] = {};
+    };
+
+    static Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    static std::string demangle(const char *mangled) {
+        int status = 0;
+        char *readable = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+        std::string name = status == 0 ? readable : mangled;
+        std::free(readable);
+        return name;
+    }
+};
+
+template <typename T>
+int class_id() {
+    static const int id = TypeRegistry::add(typeid(T).name());
+    return id;
+}
+
+inline const std::string &type_name(int id) { return TypeRegistry::name(id); }
+// ===================
+
 class Animal {
 public:
-    virtual std::string getType() const {
-        return typeid(*this).name();
+    Animal() : Animal(class_id<Animal>()) {}
+
+    // the dense class id (see DispatchTable below), stored in the object itself
+    // so that it can be read without a virtual call
+    int classId() const { return class_id_; }
+
+    // no allocation, no copy: a reference to the interned name
+    const std::string &getType() const {
+        return type_name(class_id_);
     }
 
     virtual void hello() const {
@@ -45,9 +121,30 @@ public:
     virtual ~Animal() {
         std::cout << __PRETTY_FUNCTION__ << std::endl;
     }
+
+protected:
+    explicit Animal(int class_id) : class_id_(class_id) {}
+
+private:
+    const int class_id_;
+};
+
+// CRTP: deriving from Typed<Bear> hands the id of Bear to the Animal base,
+// no class has to write down its own id.
+// For deeper hierarchies, the direct base is given as second argument,
+// e.g. class GrizzlyBear : public Typed<GrizzlyBear, Bear>.
+template <typename Derived, typename Base = Animal>
+class Typed : public Base {
+protected:
+    Typed() : Base(class_id<Derived>()) {}
+    explicit Typed(int class_id) : Base(class_id) {}
 };
 
-class Bear : public Animal {
+class Bear : public Typed<Bear> {
+protected:
+    // passes the id of a derived class on, see GrizzlyBear
+    using Typed::Typed;
+
 public:
     virtual void hello() const {
         std::cout << __PRETTY_FUNCTION__ << std::endl;
@@ -58,7 +155,11 @@ public:
     }
 };
 
-class Lemming : public Animal {
+class Lemming : public Typed<Lemming> {
+protected:
+    // passes the id of a derived class on, see GrizzlyBear
+    using Typed::Typed;
+
 public:
     virtual void hello() const {
         std::cout << __PRETTY_FUNCTION__ << std::endl;
@@ -69,6 +170,13 @@ public:
     }
 };
 
+class GrizzlyBear : public Typed<GrizzlyBear, Bear> {
+public:
+    virtual void hello() const {
+        std::cout << __PRETTY_FUNCTION__ << std::endl;
+    }
+};
+
 void SayHello(Animal *a) {
     // With single dispatch, the runtime type of one single
     // object determines the function, which will be dispatched when invoked.
@@ -104,6 +212,129 @@ void Cuddle(Lemming *l, Bear *b) {
     std::cout << __PRETTY_FUNCTION__ << std::endl;
 }
 
+// [DISPATCH TABLE] ===================
+// Real multiple dispatch has to be built by hand. One way is a chain of dynamic_casts
+// (see CuddleByCast below): every cast walks the RTTI of the class, and the chain gets
+// longer with every new class.
+//
+// The other way is a table. Every class has a small, dense integer (class_id<T>(), see above),
+// which every object carries around (Animal::classId()). The handlers are put into a
+// two dimensional table, indexed by the ids of both arguments. Dispatching is then:
+// load both ids, load the handler from the table, one indirect call. Constant time,
+// no matter how many classes there are.
+//
+// Only exact types are found in the table. Everything without a handler of its own
+// (including classes derived from Bear or Lemming) falls back to the default handler.
+template <typename Base>
+class DispatchTable {
+public:
+    using Handler = void (*)(Base *, Base *);
+
+    explicit DispatchTable(Handler fallback) : fallback(fallback), n(0) {}
+
+    // registers F for (A, B)
+    template <typename A, typename B, void (*F)(A *, B *)>
+    void define() {
+        set(class_id<A>(), class_id<B>(), [](Base *a, Base *b) { F(static_cast<A *>(a), static_cast<B *>(b)); });
+    }
+
+    // registers F for (A, B) as well as for (B, A), one handler for both orders
+    template <typename A, typename B, void (*F)(A *, B *)>
+    void define_symmetric() {
+        define<A, B, F>();
+        set(class_id<B>(), class_id<A>(), [](Base *b, Base *a) { F(static_cast<A *>(a), static_cast<B *>(b)); });
+    }
+
+    void operator()(Base *a, Base *b) const {
+        size_t i = a->classId(), j = b->classId();
+
+        // classes which got their id after the last define() can't have a handler
+        if (i >= n || j >= n) { return fallback(a, b); }
+        table[i * n + j](a, b);
+    }
+
+private:
+    void set(size_t i, size_t j, Handler h) {
+        size_t size = std::max(n, std::max(i, j) + 1);
+        if (size > n) { grow(size); }
+        table[i * n + j] = h;
+    }
+
+    // the table is dense, so new classes mean copying it into a bigger one
+    void grow(size_t size) {
+        std::vector<Handler> bigger(size * size, fallback);
+        for (size_t i = 0; i < n; i++) {
+            std::copy(table.begin() + i * n, table.begin() + (i + 1) * n, bigger.begin() + i * size);
+        }
+        table.swap(bigger);
+        n = size;
+    }
+
+    Handler fallback;
+    size_t n;
+    std::vector<Handler> table;
+};
+
+const DispatchTable<Animal> &cuddle_table() {
+    static const DispatchTable<Animal> table = [] {
+        DispatchTable<Animal> t(static_cast<void (*)(Animal *, Animal *)>(Cuddle));
+        // Cuddle(Lemming *, Bear *) is then just Cuddle(Bear *, Lemming *)
+        t.define_symmetric<Bear, Lemming, Cuddle>();
+        return t;
+    }();
+    return table;
+}
+
+// Cuddle with real multiple dispatch, resolved by the dynamic types of both arguments
+void CuddleDynamic(Animal *a, Animal *b) { cuddle_table()(a, b); }
+
+// [BENCHMARK] ===================
+// The same dispatch, once through the table and once through a chain of dynamic_casts.
+// The handlers only count, so that the dispatch itself is measured.
+static long cuddles[3];
+
+void CountCuddle(Animal *, Animal *) { cuddles[0]++; }
+void CountCuddle(Bear *, Lemming *) { cuddles[1]++; }
+void CountCuddle(Lemming *, Bear *) { cuddles[2]++; }
+
+void CuddleByCast(Animal *a, Animal *b) {
+    if (Bear *x = dynamic_cast<Bear *>(a)) {
+        if (Lemming *y = dynamic_cast<Lemming *>(b)) { return CountCuddle(x, y); }
+    } else if (Lemming *x = dynamic_cast<Lemming *>(a)) {
+        if (Bear *y = dynamic_cast<Bear *>(b)) { return CountCuddle(x, y); }
+    }
+    CountCuddle(a, b);
+}
+
+void benchmark_cuddle(size_t pairs) {
+    Bear bear;
+    Lemming lemming;
+    Animal *animals[] = {&bear, &lemming};
+
+    std::mt19937 random(42);
+    std::vector<std::pair<Animal *, Animal *>> input(pairs);
+    for (auto &p : input) { p = {animals[random() % 2], animals[random() % 2]}; }
+
+    DispatchTable<Animal> table(static_cast<void (*)(Animal *, Animal *)>(CountCuddle));
+    table.define<Bear, Lemming, CountCuddle>();
+    table.define<Lemming, Bear, CountCuddle>();
+
+    auto measure = [&](const char *name, auto dispatch) {
+        cuddles[0] = cuddles[1] = cuddles[2] = 0;
+
+        auto from = std::chrono::steady_clock::now();
+        for (auto &p : input) { dispatch(p.first, p.second); }
+        auto until = std::chrono::steady_clock::now();
+
+        std::cout << name << std::chrono::duration<double, std::nano>(until - from).count() / pairs << " ns/call"
+                  << " (" << cuddles[0] << " / " << cuddles[1] << " / " << cuddles[2] << ")" << std::endl;
+    };
+
+    measure("dynamic_cast chain: ", CuddleByCast);
+    measure("dispatch table:     ", [&](Animal *a, Animal *b) { table(a, b); });
+}
+// ===================
+
 int main() {
     Animal *a = new Bear();
     Animal *b = new Lemming();
@@ -113,6 +344,14 @@ int main() {
     SayHello(b);
     std::cout << std::endl;
 
+    std::cout << "> Type ids instead of type strings" << std::endl;
+    std::cout << a->getType() << " = " << a->classId() << ", " << b->getType() << " = " << b->classId() << std::endl;
+    std::cout << "a is a Bear: " << (a->classId() == class_id<Bear>()) << std::endl;
+    Animal *grizzly = new GrizzlyBear();
+    std::cout << grizzly->getType() << " = " << grizzly->classId() << std::endl;
+    delete grizzly;
+    std::cout << std::endl;
+
     // When we now call Cuddle with the both pointer as arguments
     // we would think that they are resolved based on their dynamic type.
     // But unfortenately, C++ doesn't provide this natively, so the fallback function
@@ -124,6 +363,18 @@ int main() {
     Cuddle(a, b);
     std::cout << std::endl;
 
+    // With the dispatch table, the dynamic types of both arguments are taken into account.
+    // Both orders end up in Cuddle(Bear *, Lemming *).
+    std::cout << "> Demonstrate multiple dynamic dispatch through a dispatch table" << std::endl;
+    CuddleDynamic(a, b);
+    CuddleDynamic(b, a);
+    CuddleDynamic(a, a);
+    std::cout << std::endl;
+
+    std::cout << "> Dispatch table vs. dynamic_cast chain" << std::endl;
+    benchmark_cuddle(10000000);
+    std::cout << std::endl;
+
     std::cout << "> Show destructor calling order (only if implemented with virtual destructors)" << std::endl;
     delete a;
     delete b;
@@ -0,0 +1,488 @@
+#include <iostream>
+#include <typeinfo>
+#include <vector>
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+// Testing in terminal:
+// g++ -o open_multimethods -std=c++17 -Wall -Wextra -pedantic open_multimethods.cpp && ./open_multimethods
+
+// ================================================================================================================
+/*
+main.cpp shows multiple dispatch for exactly two arguments, with a hand written table.
+This is the general version: open multimethods with any number of virtual arguments.
+
+"Open" means that a method is declared outside of the classes it works on, and new
+classes (or new overloads) can be added without touching any of the existing classes -
+no visitor, no accept(), no id member. A method is declared once:
+
+    using meet = declare_method<struct meet_, void(virtual_<Animal *>, virtual_<Animal *>, virtual_<Place *>)>;
+
+then overloads for concrete types are defined anywhere:
+
+    void bear_meets_lemming_in_forest(Bear *, Lemming *, Forest *) { ... }
+    define_method<meet, bear_meets_lemming_in_forest>();
+
+and after initialize() (once, at startup) the call meet::call(a, b, p) picks the most
+specific overload for the dynamic types of a, b and p.
+
+How the call works in constant time:
+  1. The dynamic type of every virtual argument is found with typeid. The address of its
+     type_info is turned into a dense class index by a perfect hash (a multiply and a shift).
+  2. For every virtual parameter, classes which select the very same overloads are merged
+     into one group. Only the groups span the dispatch table, not all the classes, which keeps
+     the table small (compressed).
+  3. The group indices make up the offset into the table, which holds the overload to call.
+
+Ambiguities (e.g. (Bear, Animal) and (Animal, Lemming) both fit (Bear, Lemming) equally well)
+are resolved deterministically: of all the equally specific overloads, the one defined first wins.
+They are counted, so they can be reported.
+
+> References:
+Open Multi-Methods for C++ (Pirkelbauer, Solodkyy, Stroustrup)
+    http://www.stroustrup.com/multimethods.pdf
+
+yomm2, the library this interface is modeled after
+    https://github.com/jll63/yomm2
+*/
+// ================================================================================================================
+
+// marks a parameter of a method as virtual, i.e. it takes part in the dispatch (pointers only)
+template <typename T>
+struct virtual_ {
+    static_assert(std::is_pointer<T>::value, "virtual arguments are passed by pointer");
+};
+
+template <typename T>
+struct strip_virtual {
+    using type = T;
+    static const bool is_virtual = false;
+};
+
+template <typename T>
+struct strip_virtual<virtual_<T>> {
+    using type = T;
+    static const bool is_virtual = true;
+};
+
+// [CLASSES] ===================
+// Every class which may show up as a virtual argument is registered, together with the classes
+// it is related to (use_classes<Animal, Bear, Lemming>()), so that std::is_base_of can tell
+// which one derives from which. Registering a class again is harmless, so a class added later
+// is registered along with its direct base: use_classes<Bear, PolarBear>(). initialize() then
+// works out the indirect relations (PolarBear is an Animal, too).
+class Classes {
+public:
+    static Classes &instance() {
+        static Classes classes;
+        return classes;
+    }
+
+    template <typename... Ts>
+    void add() {
+        const int ids[] = {intern(typeid(Ts))...};
+        size_t i = 0;
+        (add_bases_of<Ts, Ts...>(ids[i++], ids), ...);
+    }
+
+    // class index of a registered type_info, -1 if unknown
+    int index(const std::type_info &t) const {
+        uintptr_t h = (reinterpret_cast<uintptr_t>(&t) * multiplier) >> shift;
+        int i = slots[h];
+        return i >= 0 && infos[i] == &t ? i : -1;
+    }
+
+    int index_of(const std::type_info &t) const {
+        int i = index(t);
+        if (i < 0) { throw std::runtime_error(std::string("class not registered: ") + t.name()); }
+        return i;
+    }
+
+    // a is_a b: a is b or derives from it
+    bool is_a(int a, int b) const { return derived[a][b]; }
+
+    size_t size() const { return infos.size(); }
+
+    void build() {
+        build_relations();
+        build_hash();
+    }
+
+private:
+    int intern(const std::type_info &t) {
+        for (size_t i = 0; i < infos.size(); i++) {
+            if (*infos[i] == t) { return i; }
+        }
+        infos.push_back(&t);
+        bases.emplace_back();
+        return infos.size() - 1;
+    }
+
+    // bases[i] gets every class of the same use_classes call which i is or derives from
+    template <typename T, typename... Ts>
+    void add_bases_of(int i, const int *ids) {
+        size_t j = 0;
+        ((std::is_base_of<Ts, T>::value ? add_base(i, ids[j++]) : void(j++)), ...);
+    }
+
+    void add_base(int i, int base) {
+        for (int b : bases[i]) {
+            if (b == base) { return; }
+        }
+        bases[i].push_back(base);
+    }
+
+    // derived[a][b]: a reaches b following bases (which include a itself)
+    void build_relations() {
+        derived.assign(infos.size(), std::vector<bool>(infos.size(), false));
+
+        for (size_t a = 0; a < infos.size(); a++) {
+            std::vector<int> todo(1, a);
+            while (!todo.empty()) {
+                int c = todo.back();
+                todo.pop_back();
+                if (derived[a][c]) { continue; }
+                derived[a][c] = true;
+                for (int b : bases[c]) { todo.push_back(b); }
+            }
+        }
+    }
+
+    // Searches for a multiplier, so that (address * multiplier) >> shift maps every registered
+    // type_info to a different slot - a perfect hash. Starts with twice as many slots as classes.
+    void build_hash() {
+        std::mt19937_64 random(0);
+        const int max_bits = 24;
+
+        for (int bits = 1; bits <= max_bits; bits++) {
+            if ((size_t(1) << bits) < 2 * infos.size()) { continue; }
+
+            for (int attempt = 0; attempt < 10000; attempt++) {
+                multiplier = random() | 1;
+                shift = 8 * sizeof(uintptr_t) - bits;
+                slots.assign(size_t(1) << bits, -1);
+
+                bool perfect = true;
+                for (size_t i = 0; i < infos.size() && perfect; i++) {
+                    int &slot = slots[(reinterpret_cast<uintptr_t>(infos[i]) * multiplier) >> shift];
+                    if (slot >= 0) { perfect = false; }
+                    slot = i;
+                }
+                if (perfect) { return; }
+            }
+        }
+        throw std::runtime_error("no perfect hash found for the registered classes");
+    }
+
+    std::vector<const std::type_info *> infos;
+    std::vector<std::vector<int>> bases;
+    std::vector<std::vector<bool>> derived;
+
+    uintptr_t multiplier = 1;
+    int shift = 0;
+    std::vector<int> slots;
+};
+
+template <typename... Ts>
+void use_classes() { Classes::instance().add<Ts...>(); }
+// ===================
+
+// [METHODS] ===================
+class MethodBase {
+public:
+    virtual ~MethodBase() {}
+    virtual void build(const Classes &classes) = 0;
+
+    static std::vector<MethodBase *> &all() {
+        static std::vector<MethodBase *> methods;
+        return methods;
+    }
+};
+
+// builds the class hash and the dispatch tables of all methods, call it once at startup
+// (after all use_classes and define_method, before the first call)
+void initialize() {
+    Classes::instance().build();
+    for (MethodBase *m : MethodBase::all()) { m->build(Classes::instance()); }
+}
+
+template <typename Name, typename Signature>
+class declare_method;
+
+template <typename Name, typename R, typename... Params>
+class declare_method<Name, R(Params...)> : public MethodBase {
+public:
+    using Handler = R (*)(typename strip_virtual<Params>::type...);
+    static const size_t arity = (0 + ... + strip_virtual<Params>::is_virtual);
+
+    static_assert(arity > 0, "a method needs at least one virtual argument");
+
+    static declare_method &instance() {
+        static declare_method *method = [] {
+            declare_method *m = new declare_method();
+            MethodBase::all().push_back(m);
+            return m;
+        }();
+        return *method;
+    }
+
+    static R call(typename strip_virtual<Params>::type... args) {
+        const declare_method &m = instance();
+        const Classes &classes = Classes::instance();
+        if (m.table.empty()) { throw std::runtime_error("method called before initialize()"); }
+
+        size_t offset = 0, v = 0;
+        auto add = [&](auto is_virtual, auto arg) {
+            if constexpr (decltype(is_virtual)::value) {
+                size_t group = m.groups[v][classes.index_of(typeid(*arg))];
+                if (group == unrelated) { throw std::runtime_error("class not registered as derived from the parameter type"); }
+                offset += group * m.strides[v];
+                v++;
+            }
+        };
+        (add(std::integral_constant<bool, strip_virtual<Params>::is_virtual>(), args), ...);
+
+        return m.table[offset](args...);
+    }
+
+    void add(Handler handler, std::vector<const std::type_info *> types) {
+        overloads.push_back(Overload{handler, types});
+    }
+
+    size_t ambiguities() const { return ambiguous; }
+    size_t tableSize() const { return table.size(); }
+
+private:
+    struct Overload {
+        Handler handler;
+        std::vector<const std::type_info *> types; // of the virtual parameters
+    };
+
+    // group of the classes which don't derive from the type of the parameter
+    static constexpr size_t unrelated = size_t(-1);
+
+    static R not_implemented(typename strip_virtual<Params>::type...) {
+        throw std::runtime_error("no overload of the method matches the dynamic types of its arguments");
+    }
+
+    void build(const Classes &classes) override {
+        const std::type_info *base_types[] = {
+            (strip_virtual<Params>::is_virtual ? &typeid(std::remove_pointer_t<typename strip_virtual<Params>::type>)
+                                               : nullptr)...
+        };
+        std::vector<int> base;
+        for (const std::type_info *t : base_types) {
+            if (t) { base.push_back(classes.index_of(*t)); }
+        }
+
+        // class indices of the parameters of every overload, [overload][v]
+        std::vector<std::vector<int>> params;
+        for (const Overload &o : overloads) {
+            params.emplace_back();
+            for (const std::type_info *t : o.types) { params.back().push_back(classes.index_of(*t)); }
+        }
+
+        // Group the classes per parameter by the overloads they are applicable to.
+        // group_masks[v][g] is the set of overloads applicable to the classes of group g.
+        groups.assign(arity, std::vector<size_t>(classes.size(), unrelated));
+        std::vector<std::vector<std::vector<bool>>> group_masks(arity);
+
+        for (size_t v = 0; v < arity; v++) {
+            std::map<std::vector<bool>, size_t> known;
+
+            for (size_t c = 0; c < classes.size(); c++) {
+                if (!classes.is_a(c, base[v])) { continue; }
+
+                std::vector<bool> mask(overloads.size());
+                for (size_t o = 0; o < overloads.size(); o++) { mask[o] = classes.is_a(c, params[o][v]); }
+
+                auto it = known.find(mask);
+                if (it == known.end()) {
+                    it = known.emplace(mask, group_masks[v].size()).first;
+                    group_masks[v].push_back(mask);
+                }
+                groups[v][c] = it->second;
+            }
+        }
+
+        strides.assign(arity, 1);
+        size_t size = 1;
+        for (size_t v = 0; v < arity; v++) {
+            strides[v] = size;
+            size *= group_masks[v].size();
+        }
+
+        // fill every cell of the table with the most specific applicable overload
+        table.assign(size, not_implemented);
+        ambiguous = 0;
+
+        for (size_t cell = 0; cell < size; cell++) {
+            std::vector<size_t> applicable;
+            for (size_t o = 0; o < overloads.size(); o++) {
+                bool fits = true;
+                for (size_t v = 0; v < arity && fits; v++) {
+                    fits = group_masks[v][cell / strides[v] % group_masks[v].size()][o];
+                }
+                if (fits) { applicable.push_back(o); }
+            }
+
+            // the candidates which no other applicable overload is more specific than
+            std::vector<size_t> best;
+            for (size_t a : applicable) {
+                bool dominated = false;
+                for (size_t b : applicable) {
+                    if (a != b && more_specific(classes, params[b], params[a])) { dominated = true; }
+                }
+                if (!dominated) { best.push_back(a); }
+            }
+
+            if (best.size() > 1) { ambiguous++; }
+            // applicable keeps the order of definition, so the first one defined wins ties
+            if (!best.empty()) { table[cell] = overloads[best.front()].handler; }
+        }
+    }
+
+    // a is more specific than b: every parameter of a is_a the one of b, and they aren't all equal
+    static bool more_specific(const Classes &classes, const std::vector<int> &a, const std::vector<int> &b) {
+        bool differs = false;
+        for (size_t v = 0; v < a.size(); v++) {
+            if (!classes.is_a(a[v], b[v])) { return false; }
+            if (a[v] != b[v]) { differs = true; }
+        }
+        return differs;
+    }
+
+    std::vector<Overload> overloads;
+
+    std::vector<std::vector<size_t>> groups; // [v][class index] -> group
+    std::vector<size_t> strides;             // [v]
+    std::vector<Handler> table;
+    size_t ambiguous = 0;
+};
+
+template <typename Method, typename Overload>
+struct Definer;
+
+template <typename Name, typename R, typename... Params, typename... Ts>
+struct Definer<declare_method<Name, R(Params...)>, R (*)(Ts...)> {
+    static_assert(sizeof...(Params) == sizeof...(Ts), "the overload must have as many parameters as the method");
+
+    template <R (*F)(Ts...)>
+    static R trampoline(typename strip_virtual<Params>::type... args) {
+        return F(static_cast<Ts>(args)...);
+    }
+
+    template <R (*F)(Ts...)>
+    static void define() {
+        std::vector<const std::type_info *> types;
+        ((strip_virtual<Params>::is_virtual ? types.push_back(&typeid(std::remove_pointer_t<Ts>)) : void()), ...);
+
+        declare_method<Name, R(Params...)>::instance().add(trampoline<F>, types);
+    }
+};
+
+// Adds F as an overload of Method. The parameters of F at the virtual positions of the
+// method are pointers to (more) derived classes, the others have to match exactly.
+template <typename Method, auto F>
+void define_method() { Definer<Method, decltype(F)>::template define<F>(); }
+// ===================
+
+// [EXAMPLE] ===================
+// The classes know nothing about any method.
+class Animal { public: virtual ~Animal() {} };
+class Bear : public Animal {};
+class GrizzlyBear : public Bear {};
+class Lemming : public Animal {};
+// added later, in a registration of its own
+class PolarBear : public Bear {};
+
+class Place { public: virtual ~Place() {} };
+class Forest : public Place {};
+class Tundra : public Place {};
+
+// two virtual arguments, like Cuddle in main.cpp
+using cuddle = declare_method<struct cuddle_, void(virtual_<Animal *>, virtual_<Animal *>)>;
+
+void cuddle_animals(Animal *, Animal *) { std::cout << "two animals cuddle" << std::endl; }
+void cuddle_bear_lemming(Bear *, Lemming *) { std::cout << "a bear cuddles a lemming" << std::endl; }
+void cuddle_lemming_bear(Lemming *, Bear *) { std::cout << "a lemming cuddles a bear" << std::endl; }
+void cuddle_grizzly_animal(GrizzlyBear *, Animal *) { std::cout << "a grizzly cuddles anything" << std::endl; }
+
+// three virtual arguments and a plain one
+using meet = declare_method<struct meet_, std::string(virtual_<Animal *>, virtual_<Animal *>, virtual_<Place *>, int)>;
+
+std::string meet_anywhere(Animal *, Animal *, Place *, int hour) {
+    return "two animals meet at " + std::to_string(hour) + " o'clock";
+}
+std::string meet_bear_lemming_forest(Bear *, Lemming *, Forest *, int) {
+    return "a bear meets a lemming in the forest";
+}
+std::string meet_animal_lemming_tundra(Animal *, Lemming *, Tundra *, int) {
+    return "something meets a lemming in the tundra";
+}
+std::string meet_bear_animal_tundra(Bear *, Animal *, Tundra *, int) {
+    return "a bear meets something in the tundra";
+}
+// ===================
+
+int main() {
+    use_classes<Animal, Bear, GrizzlyBear, Lemming>();
+    use_classes<Place, Forest, Tundra>();
+    use_classes<Bear, PolarBear>();
+
+    define_method<cuddle, cuddle_animals>();
+    define_method<cuddle, cuddle_bear_lemming>();
+    define_method<cuddle, cuddle_lemming_bear>();
+    define_method<cuddle, cuddle_grizzly_animal>();
+
+    define_method<meet, meet_anywhere>();
+    define_method<meet, meet_bear_lemming_forest>();
+    define_method<meet, meet_animal_lemming_tundra>();
+    define_method<meet, meet_bear_animal_tundra>();
+
+    initialize();
+
+    Animal *bear = new Bear{};
+    Animal *grizzly = new GrizzlyBear{};
+    Animal *lemming = new Lemming{};
+    Animal *polar = new PolarBear{};
+    Place *forest = new Forest{};
+    Place *tundra = new Tundra{};
+
+    std::cout << "> cuddle, two virtual arguments" << std::endl;
+    cuddle::call(bear, lemming);
+    cuddle::call(lemming, bear);
+    cuddle::call(lemming, lemming);
+    // GrizzlyBear has no overload of its own for (Grizzly, Lemming), but two candidates:
+    // (GrizzlyBear, Animal) and (Bear, Lemming) - ambiguous, the one defined first wins
+    cuddle::call(grizzly, lemming);
+    // PolarBear is only known to derive from Bear, the rest is worked out
+    cuddle::call(polar, lemming);
+    std::cout << "table cells: " << cuddle::instance().tableSize()
+              << ", ambiguous: " << cuddle::instance().ambiguities() << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "> meet, three virtual arguments" << std::endl;
+    std::cout << meet::call(bear, lemming, forest, 12) << std::endl;
+    std::cout << meet::call(grizzly, lemming, forest, 12) << std::endl;
+    std::cout << meet::call(lemming, lemming, tundra, 12) << std::endl;
+    std::cout << meet::call(bear, bear, tundra, 12) << std::endl;
+    std::cout << meet::call(lemming, bear, forest, 23) << std::endl;
+    // (Bear, Lemming, Tundra) fits (Animal, Lemming, Tundra) as well as (Bear, Animal, Tundra)
+    std::cout << meet::call(bear, lemming, tundra, 12) << std::endl;
+    std::cout << "table cells: " << meet::instance().tableSize()
+              << " (instead of 5 * 5 * 3 = 75), ambiguous: " << meet::instance().ambiguities() << std::endl;
+
+    delete bear;
+    delete grizzly;
+    delete lemming;
+    delete polar;
+    delete forest;
+    delete tundra;
+}
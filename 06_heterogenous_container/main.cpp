@@ -1,18 +1,123 @@
 #include <iostream>
 #include <typeinfo>
+#include <typeindex>
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <new>
+#include <variant>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <optional>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <cstdlib>
+#include <cxxabi.h>
+
+// Testing in terminal:
+// g++ -o main -std=c++17 -Wall -Wextra -pedantic -pthread main.cpp && ./main
+
+// [TYPE IDS] ===================
+// typeid(*this).name() builds a new std::string with the mangled name on every call,
+// just to find out what an object is. Instead, every class gets a small, dense integer id
+// (0, 1, 2, ...) the first time class_id<T>() is used. The id never changes afterwards,
+// so checking a type is an integer compare, and the ids can index into tables directly.
+//
+// The (demangled) name of every class is interned once, type_name(id) hands out a
+// reference to it - only needed for diagnostics.
+class TypeRegistry {
+public:
+    static const int max_types = 1024;
+
+    static int add(const char *mangled) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+
+        int id = r.names.size();
+        if (id >= max_types) { throw std::length_error("too many registered types"); }
+
+        r.names.push_back(demangle(mangled));
+        r.published[id].store(&r.names.back(), std::memory_order_release);
+        return id;
+    }
+
+    // lock-free, the name of an id never changes once it is published
+    static const std::string &name(int id) { return *registry().published[id].load(std::memory_order_acquire); }
+
+private:
+    struct Registry {
+        std::mutex lock;
+        std::deque<std::string> names; // a deque never moves its elements
+        std::atomic<const std::string *> published[max_types] = {};
+    };
+
+    static Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    static std::string demangle(const char *mangled) {
+        int status = 0;
+        char *readable = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+        std::string name = status == 0 ? readable : mangled;
+        std::free(readable);
+        return name;
+    }
+};
+
+template <typename T>
+int class_id() {
+    static const int id = TypeRegistry::add(typeid(T).name());
+    return id;
+}
+
+inline const std::string &type_name(int id) { return TypeRegistry::name(id); }
+// ===================
 
 class Animal {
 public:
-    virtual std::string type() const { return typeid(*this).name(); }
+    // a dense id per class, comparing two of them is all it takes to check a type
+    virtual int classId() const = 0;
+
+    // the interned name, for diagnostics
+    const std::string &type() const { return type_name(classId()); }
+
+    virtual int legs() const = 0;
     virtual ~Animal() {}
 };
 
-class Bat : public Animal {};
-class Bear : public Animal {};
-class Moose : public Animal {};
-class Shark : public Animal {};
-class Squirrel : public Animal {};
+// CRTP: every animal derives from Typed<Itself> and gets its classId() for free
+template <typename Derived>
+class Typed : public Animal {
+public:
+    int classId() const override { return class_id<Derived>(); }
+};
+
+// final: nothing derives from them, so a call on a Bat & (instead of an Animal &)
+// can be bound statically by the compiler (devirtualized)
+class Bat final : public Typed<Bat> { public: int legs() const override { return 2; } };
+class Bear final : public Typed<Bear> { public: int legs() const override { return 4; } };
+class Moose final : public Typed<Moose> { public: int legs() const override { return 4; } };
+class Shark final : public Typed<Shark> { public: int legs() const override { return 0; } };
+class Squirrel final : public Typed<Squirrel> { public: int legs() const override { return 4; } };
+
+// too big for the inline buffer of AnyAnimal (see below)
+class Whale final : public Typed<Whale> {
+public:
+    int legs() const override { return 0; }
+
+private:
+    double blubber[32] = {};
+};
 
 void printZoo(std::vector<Animal *> &zoo) {
     for (Animal *a : zoo) {
@@ -20,6 +125,441 @@ void printZoo(std::vector<Animal *> &zoo) {
     }
 }
 
+// A std::vector<Animal *> scatters its elements all over the heap (every one was new'ed on its own),
+// and every element costs a pointer dereference plus a virtual call, whose target changes
+// from element to element.
+//
+// A PolyCollection stores the objects themselves (not pointers), every concrete type in its
+// own contiguous std::vector, a so called segment. It is traversed segment by segment:
+//   - the elements of a segment lie next to each other in memory (cache friendly)
+//   - all elements of a segment have the same type, so the virtual calls always
+//     go to the same target (branch prediction friendly)
+//   - for_each<Bat, Bear>(f) even hands out Bat & and Bear &, so that f can be bound
+//     statically to the concrete type, no virtual dispatch at all
+//
+// The price: the order of insertion is only kept within a type, not across types.
+template <typename Base>
+class PolyCollection {
+public:
+    template <typename T, typename... Args>
+    T &emplace(Args &&... args) {
+        return segment<T>().elements.emplace_back(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T &insert(T value) { return emplace<T>(std::move(value)); }
+
+    // visits every element through the Base interface, type by type
+    template <typename F>
+    void for_each(F f) {
+        for (auto &s : segments) {
+            s->for_each([](void *context, Base &element) { (*static_cast<F *>(context))(element); }, &f, 0, s->size());
+        }
+    }
+
+    // visits only the elements of the given types, f gets called with the concrete type (T &)
+    template <typename T, typename... Ts, typename F>
+    void for_each(F f) {
+        for_each_of<T>(f);
+        (for_each_of<Ts>(f), ...);
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (auto &s : segments) { n += s->size(); }
+        return n;
+    }
+
+    template <typename T>
+    size_t size() const {
+        auto it = index.find(typeid(T));
+        return it == index.end() ? 0 : it->second->size();
+    }
+
+    // [PARALLEL] ===================
+    // The elements are split into one contiguous range per thread, over all segments
+    // laid end to end. So every thread walks through just one or two segments, i.e. keeps
+    // calling the same functions (hot vtable and instruction cache), instead of hopping
+    // between types.
+    //
+    // range(each, worker) runs once per thread, each(g) calls g(element) for the elements of its
+    // range. Whatever a thread accumulates belongs into locals of range(), written to shared
+    // per-thread slots once at the end: per-thread slots next to each other in a vector share
+    // cache lines, and writing them per element makes the threads steal the lines from each
+    // other all the time (false sharing).
+    template <typename Range>
+    void parallel_for_ranges(Range range, unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) { threads = 1; }
+        const size_t n = size();
+
+        auto work = [&](unsigned worker) {
+            size_t from = n * worker / threads, until = n * (worker + 1) / threads;
+
+            // skip the segments before from, then run over [from, until)
+            auto each = [&](auto g) {
+                size_t offset = 0;
+                for (auto &s : segments) {
+                    size_t begin = std::max(from, offset), end = std::min(until, offset + s->size());
+                    if (begin < end) {
+                        using G = decltype(g);
+                        s->for_each([](void *context, Base &element) { (*static_cast<G *>(context))(element); },
+                                    &g, begin - offset, end - offset);
+                    }
+                    offset += s->size();
+                }
+            };
+            range(each, worker);
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; t++) { workers.emplace_back(work, t); }
+        work(0);
+        for (std::thread &worker : workers) { worker.join(); }
+    }
+
+    // f(element, worker) also gets the index of the thread - for anything accumulated per
+    // thread, prefer parallel_for_ranges (see above)
+    template <typename F>
+    void parallel_for_each(F f, unsigned threads = std::thread::hardware_concurrency()) {
+        parallel_for_ranges([&f](auto &each, unsigned worker) {
+            each([&f, worker](Base &element) { f(element, worker); });
+        }, threads);
+    }
+
+    // init + the reduction of transform(element) over all elements. Every thread reduces
+    // its own range first, the per-thread results are combined once at the end (in order).
+    // reduce has to be associative.
+    template <typename T, typename Reduce, typename Transform>
+    T parallel_transform_reduce(T init, Reduce reduce, Transform transform,
+                                unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) { threads = 1; }
+        std::vector<std::optional<T>> partial(threads);
+
+        parallel_for_ranges([&](auto &each, unsigned worker) {
+            std::optional<T> p;
+            each([&](Base &element) { p = p ? reduce(std::move(*p), transform(element)) : transform(element); });
+            partial[worker] = std::move(p);
+        }, threads);
+
+        for (std::optional<T> &p : partial) {
+            if (p) { init = reduce(std::move(init), std::move(*p)); }
+        }
+        return init;
+    }
+    // ===================
+
+private:
+    struct Segment {
+        virtual ~Segment() {}
+        virtual size_t size() const = 0;
+
+        // one indirect call per element, instead of a template (templates can't be virtual)
+        virtual void for_each(void (*f)(void *, Base &), void *context, size_t begin, size_t end) = 0;
+    };
+
+    template <typename T>
+    struct TypedSegment : Segment {
+        size_t size() const override { return elements.size(); }
+
+        void for_each(void (*f)(void *, Base &), void *context, size_t begin, size_t end) override {
+            for (size_t i = begin; i < end; i++) { f(context, elements[i]); }
+        }
+
+        std::vector<T> elements;
+    };
+
+    template <typename T>
+    TypedSegment<T> &segment() {
+        static_assert(std::is_base_of<Base, T>::value, "only types derived from Base can be stored");
+
+        Segment *&s = index[typeid(T)];
+        if (!s) {
+            segments.push_back(std::make_unique<TypedSegment<T>>());
+            s = segments.back().get();
+        }
+        return static_cast<TypedSegment<T> &>(*s);
+    }
+
+    template <typename T, typename F>
+    void for_each_of(F &f) {
+        auto it = index.find(typeid(T));
+        if (it == index.end()) { return; }
+
+        for (T &element : static_cast<TypedSegment<T> &>(*it->second).elements) { f(element); }
+    }
+
+    // in the order the types were first inserted
+    std::vector<std::unique_ptr<Segment>> segments;
+    std::unordered_map<std::type_index, Segment *> index;
+};
+
+void printZoo(PolyCollection<Animal> &zoo) {
+    zoo.for_each([](Animal &a) {
+        std::cout << a.type() << std::endl;
+    });
+}
+
+// Writing to std::cout from several threads interleaves the lines and costs a syscall
+// (or at least a lock) per element. Instead, every thread writes into its own buffer,
+// and the buffers are printed at once, in order, at the end.
+void printZoo(PolyCollection<Animal> &zoo, unsigned threads) {
+    std::vector<std::string> buffers(threads == 0 ? 1 : threads);
+
+    zoo.parallel_for_ranges([&](auto &each, unsigned worker) {
+        std::string buffer;
+        each([&buffer](Animal &a) {
+            buffer += a.type();
+            buffer += '\n';
+        });
+        buffers[worker] = std::move(buffer);
+    }, threads);
+
+    std::string out;
+    for (const std::string &buffer : buffers) { out += buffer; }
+    std::cout << out << std::flush;
+}
+
+// PolyCollection gives up the order of the elements. If the order matters, a std::vector is still
+// the way to go - but of values, not of raw owning pointers (the zoo above never deletes its animals,
+// and every animal is a heap allocation of its own).
+//
+// AnyAnimal is such a value: it holds any type derived from Animal (type erasure), can be copied
+// and moved like an int, and cleans up after itself. Small animals (all of the ones above) live
+// in an inline buffer inside the AnyAnimal itself, so a std::vector<AnyAnimal> is one contiguous
+// block without any further allocation. Only animals too big for the buffer go to the heap.
+class AnyAnimal {
+public:
+    static const size_t buffer_size = 3 * sizeof(void *);
+
+    // an empty AnyAnimal, which is also what a moved-from one turns into
+    AnyAnimal() : ops(nullptr) {}
+
+    template <typename T, typename = typename std::enable_if<
+            std::is_base_of<Animal, typename std::decay<T>::type>::value>::type>
+    AnyAnimal(T &&animal) : ops(&Model<typename std::decay<T>::type>::ops) {
+        Model<typename std::decay<T>::type>::construct(storage, std::forward<T>(animal));
+    }
+
+    AnyAnimal(const AnyAnimal &other) : ops(other.ops) {
+        if (ops) { ops->copy(other.storage, storage); }
+    }
+
+    AnyAnimal(AnyAnimal &&other) noexcept : ops(other.ops) {
+        if (ops) { ops->move(other.storage, storage); }
+        other.ops = nullptr;
+    }
+
+    AnyAnimal &operator=(const AnyAnimal &other) {
+        if (this != &other) { *this = AnyAnimal(other); }
+        return *this;
+    }
+
+    AnyAnimal &operator=(AnyAnimal &&other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) { ops->move(other.storage, storage); }
+            other.ops = nullptr;
+        }
+        return *this;
+    }
+
+    ~AnyAnimal() { reset(); }
+
+    bool empty() const { return ops == nullptr; }
+    bool isInline() const { return ops && ops->inline_storage; }
+
+    Animal &operator*() { return *ops->get(storage); }
+    const Animal &operator*() const { return *ops->get(const_cast<Storage &>(storage)); }
+    Animal *operator->() { return &**this; }
+    const Animal *operator->() const { return &**this; }
+
+private:
+    union Storage {
+        alignas(std::max_align_t) unsigned char buffer[buffer_size];
+        Animal *heap;
+    };
+
+    // what is needed to copy, move and destroy the stored type, one table per type
+    struct Ops {
+        void (*copy)(const Storage &from, Storage &to);
+        void (*move)(Storage &from, Storage &to) noexcept; // leaves from destroyed
+        void (*destroy)(Storage &s) noexcept;
+        Animal *(*get)(Storage &s);
+        bool inline_storage;
+    };
+
+    template <typename T, bool Inline = sizeof(T) <= buffer_size &&
+                                        alignof(T) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible<T>::value>
+    struct Model;
+
+    template <typename T>
+    struct Model<T, true> {
+        template <typename U>
+        static void construct(Storage &s, U &&animal) { new (s.buffer) T(std::forward<U>(animal)); }
+
+        static T *self(Storage &s) { return std::launder(reinterpret_cast<T *>(s.buffer)); }
+
+        static void copy(const Storage &from, Storage &to) { construct(to, *self(const_cast<Storage &>(from))); }
+        static void move(Storage &from, Storage &to) noexcept {
+            construct(to, std::move(*self(from)));
+            destroy(from);
+        }
+        static void destroy(Storage &s) noexcept { self(s)->~T(); }
+        static Animal *get(Storage &s) { return self(s); }
+
+        static const Ops ops;
+    };
+
+    template <typename T>
+    struct Model<T, false> {
+        template <typename U>
+        static void construct(Storage &s, U &&animal) { s.heap = new T(std::forward<U>(animal)); }
+
+        static void copy(const Storage &from, Storage &to) { to.heap = new T(static_cast<const T &>(*from.heap)); }
+        // moving just hands the pointer over
+        static void move(Storage &from, Storage &to) noexcept { to.heap = from.heap; }
+        static void destroy(Storage &s) noexcept { delete static_cast<T *>(s.heap); }
+        static Animal *get(Storage &s) { return s.heap; }
+
+        static const Ops ops;
+    };
+
+    void reset() {
+        if (ops) { ops->destroy(storage); }
+        ops = nullptr;
+    }
+
+    const Ops *ops;
+    Storage storage;
+};
+
+template <typename T>
+const AnyAnimal::Ops AnyAnimal::Model<T, true>::ops = {copy, move, destroy, get, true};
+
+template <typename T>
+const AnyAnimal::Ops AnyAnimal::Model<T, false>::ops = {copy, move, destroy, get, false};
+
+void printZoo(const std::vector<AnyAnimal> &zoo) {
+    for (const AnyAnimal &a : zoo) {
+        std::cout << a->type() << (a.isInline() ? "" : " (heap)") << std::endl;
+    }
+}
+
+// [VARIANT] ===================
+// The zoo only ever holds these five animals, the set is closed. For a closed set there is no
+// need for open (virtual) dispatch, a std::variant can hold any one of them by value.
+// std::visit then picks the right function out of a table indexed by the variant's
+// type index (a jump table), and inside the visitor the type is known statically.
+//
+// The price: a new animal means touching ZooAnimal (and every visitor which
+// doesn't handle all types generically).
+using ZooAnimal = std::variant<Bat, Bear, Moose, Shark, Squirrel>;
+using VariantZoo = std::vector<ZooAnimal>;
+
+// the classic helper to build a visitor out of several lambdas:
+//     std::visit(overloaded{ [](const Bat &) { ... }, [](const auto &) { ... } }, animal);
+template <typename... Fs>
+struct overloaded : Fs... { using Fs::operator()...; };
+
+template <typename... Fs>
+overloaded(Fs...) -> overloaded<Fs...>;
+
+// every variant alternative is an Animal, so the common interface is always at hand
+const Animal &as_animal(const ZooAnimal &a) {
+    return std::visit([](const Animal &animal) -> const Animal & { return animal; }, a);
+}
+
+template <typename F>
+void visit_each(const VariantZoo &zoo, F f) {
+    for (const ZooAnimal &a : zoo) { std::visit(f, a); }
+}
+
+void printZoo(const VariantZoo &zoo) {
+    visit_each(zoo, overloaded{
+        [](const Shark &s) { std::cout << s.type() << " (no legs, but fins)" << std::endl; },
+        [](const auto &a) { std::cout << a.type() << std::endl; }
+    });
+}
+
+// Virtual calls through std::vector<Animal *> against std::visit over std::vector<ZooAnimal>,
+// with the animals in random order (so the branch predictor can't simply guess the type).
+// legs() and classId() are as cheap as a call gets. type() itself isn't virtual, it looks up the
+// interned name by classId() - a virtual call through the pointer, a static one inside std::visit.
+//
+// Every case is warmed up once (page faults, caches, branch predictors), then run rounds times;
+// reported are the best and the median round.
+void benchmark_dispatch(size_t n, int rounds = 5) {
+    std::mt19937 random(42);
+
+    std::vector<std::unique_ptr<Animal>> owner;
+    std::vector<Animal *> pointers;
+    VariantZoo variants;
+    owner.reserve(n);
+    pointers.reserve(n);
+    variants.reserve(n);
+
+    for (size_t i = 0; i < n; i++) {
+        switch (random() % 5) {
+            case 0: owner.push_back(std::make_unique<Bat>()); variants.emplace_back(Bat{}); break;
+            case 1: owner.push_back(std::make_unique<Bear>()); variants.emplace_back(Bear{}); break;
+            case 2: owner.push_back(std::make_unique<Moose>()); variants.emplace_back(Moose{}); break;
+            case 3: owner.push_back(std::make_unique<Shark>()); variants.emplace_back(Shark{}); break;
+            default: owner.push_back(std::make_unique<Squirrel>()); variants.emplace_back(Squirrel{}); break;
+        }
+        pointers.push_back(owner.back().get());
+    }
+
+    auto measure = [n, rounds](const char *name, auto f) {
+        long long result = f();
+
+        std::vector<double> ns(rounds);
+        for (double &round : ns) {
+            auto from = std::chrono::steady_clock::now();
+            result += f();
+            auto until = std::chrono::steady_clock::now();
+            round = std::chrono::duration<double, std::nano>(until - from).count() / n;
+        }
+        std::sort(ns.begin(), ns.end());
+
+        std::cout << name << ": " << ns.front() << " ns/element best, " << ns[ns.size() / 2]
+                  << " median (" << result / (rounds + 1) << ")" << std::endl;
+    };
+
+    measure("virtual a->legs()          ", [&] {
+        long long legs = 0;
+        for (Animal *a : pointers) { legs += a->legs(); }
+        return legs;
+    });
+    measure("std::visit legs()          ", [&] {
+        long long legs = 0;
+        for (const ZooAnimal &a : variants) { legs += std::visit([](const auto &x) { return x.legs(); }, a); }
+        return legs;
+    });
+    measure("virtual a->classId()       ", [&] {
+        long long ids = 0;
+        for (Animal *a : pointers) { ids += a->classId(); }
+        return ids;
+    });
+    measure("std::visit classId()       ", [&] {
+        long long ids = 0;
+        for (const ZooAnimal &a : variants) { ids += std::visit([](const auto &x) { return x.classId(); }, a); }
+        return ids;
+    });
+    measure("a->type(), virtual classId ", [&] {
+        long long length = 0;
+        for (Animal *a : pointers) { length += a->type().size(); }
+        return length;
+    });
+    measure("std::visit type()          ", [&] {
+        long long length = 0;
+        for (const ZooAnimal &a : variants) { length += std::visit([](const auto &x) -> const std::string & { return x.type(); }, a).size(); }
+        return length;
+    });
+}
+// ===================
+
 int main() {
     // Whenever a variable may contain references (pointer) to objects other classes,
     // it is called a heterogenous data structure. As here, vector is a container where
@@ -37,4 +577,67 @@ int main() {
     zoo.push_back(new Squirrel{});
 
     printZoo(zoo);
-}
\ No newline at end of file
+    std::cout << std::endl;
+
+    // the container only holds the pointers, the animals have to be deleted by hand
+    for (Animal *a : zoo) { delete a; }
+    zoo.clear();
+
+    // The same zoo as values, contiguous and without leaks. Only the whale needs the heap.
+    std::vector<AnyAnimal> values;
+
+    values.emplace_back(Bat{});
+    values.emplace_back(Bear{});
+    values.emplace_back(Moose{});
+    values.emplace_back(Shark{});
+    values.emplace_back(Squirrel{});
+    values.emplace_back(Whale{});
+
+    // a copy is a deep copy, like with any other value type
+    std::vector<AnyAnimal> copied = values;
+    printZoo(copied);
+    std::cout << std::endl;
+
+    // The same zoo, but every animal type in its own contiguous segment.
+    // Note how the bats end up next to each other, even though they weren't inserted one after another.
+    PolyCollection<Animal> collection;
+
+    collection.insert(Bat{});
+    collection.insert(Bear{});
+    collection.insert(Moose{});
+    collection.insert(Shark{});
+    collection.insert(Squirrel{});
+    collection.insert(Bat{});
+
+    printZoo(collection);
+    std::cout << std::endl;
+
+    // only the bats and bears, f is instantiated for Bat & and Bear &,
+    // so a.type() is bound at compile time (the classes are final)
+    collection.for_each<Bat, Bear>([](auto &a) {
+        std::cout << a.type() << std::endl;
+    });
+    std::cout << collection.size() << " animals, " << collection.size<Bat>() << " of them bats" << std::endl;
+    std::cout << std::endl;
+
+    printZoo(collection, 3);
+    std::cout << std::endl;
+
+    // a million animals, their legs counted by all cores
+    PolyCollection<Animal> big;
+    for (int i = 0; i < 200000; i++) {
+        big.insert(Bat{}); big.insert(Bear{}); big.insert(Moose{}); big.insert(Shark{}); big.insert(Squirrel{});
+    }
+
+    long long legs = big.parallel_transform_reduce(0LL, std::plus<long long>(), 
+            [](const Animal &a) { return static_cast<long long>(a.legs()); });
+    std::cout << big.size() << " animals with " << legs << " legs" << std::endl;
+    std::cout << std::endl;
+
+    VariantZoo variants = { Bat{}, Bear{}, Moose{}, Shark{}, Squirrel{} };
+    printZoo(variants);
+    std::cout << "legs of the first one: " << as_animal(variants.front()).legs() << std::endl;
+    std::cout << std::endl;
+
+    benchmark_dispatch(10000000);
+}
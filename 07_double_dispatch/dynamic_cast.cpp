@@ -1,34 +1,285 @@
 #include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
 
-#define M() std::cout << __PRETTY_FUNCTION__ << std::endl;
+// Testing in terminal:
+// g++ -o dynamic_cast -std=c++11 -O2 -Wall -Wextra dynamic_cast.cpp && ./dynamic_cast
+
+static bool trace = true;
+
+#define M() do { if (trace) { std::cout << __PRETTY_FUNCTION__ << std::endl; } } while (0)
+
+// [SHIP IDS] ===================
+// Every ship class gets a dense id (0, 1, 2, ...) the first time it is asked for.
+// The id is stored in the object, so reading it is a plain load, no RTTI involved.
+// Next to the ids, ShipTypes remembers the id of the parent of every ship type (-1 for
+// SpaceShip), so a handler for a ship type can be found for its subclasses as well.
+// A parent always gets its id before its subclasses, i.e. a smaller one.
+// (locked, so ship types first used on different threads don't get the same id)
+class ShipTypes {
+public:
+    static int add(int parent) {
+        std::lock_guard<std::mutex> lock(mutex());
+        parents().push_back(parent);
+        return static_cast<int>(parents().size()) - 1;
+    }
+
+    static int parent(int id) {
+        std::lock_guard<std::mutex> lock(mutex());
+        return parents()[id];
+    }
+
+    static int count() {
+        std::lock_guard<std::mutex> lock(mutex());
+        return static_cast<int>(parents().size());
+    }
+
+private:
+    static std::mutex &mutex() { static std::mutex m; return m; }
+    static std::vector<int> &parents() { static std::vector<int> p; return p; }
+};
+
+class SpaceShip;
+
+template <typename T>
+int ship_id();
+
+// the parent of a ship type is the Base it passed to ShipType
+template <typename T>
+int parent_ship_id() { return ship_id<typename T::parent_type>(); }
+
+template <>
+inline int parent_ship_id<SpaceShip>() { return -1; }
+
+template <typename T>
+int ship_id() {
+    static const int id = ShipTypes::add(parent_ship_id<T>());
+    return id;
+}
+// ===================
 
 class SpaceShip {
 public:
+    SpaceShip() : type(ship_id<SpaceShip>()) {}
     virtual ~SpaceShip() { M(); }
+
+    int id() const { return type; }
+
+private:
+    template <typename, typename> friend class ShipType;
+    int type;
+};
+
+// class Ship : public ShipType<Ship> {}
+// class Cargo : public ShipType<Cargo, Ship> {}
+//
+// Each ShipType sets the id of its Derived while the ship is constructed, so - like the
+// vtable pointer - the id of the most derived type wins.
+template <typename Derived, typename Base = SpaceShip>
+class ShipType : public Base {
+public:
+    typedef Base parent_type;
+
+protected:
+    ShipType() { static_cast<SpaceShip *>(this)->type = ship_id<Derived>(); }
+};
+
+class ApolloSpacecraft : public ShipType<ApolloSpacecraft> { public: ~ApolloSpacecraft() { M(); } };
+
+// no handler of its own, collides as an ApolloSpacecraft - with either kind of dispatch
+class LunarModule : public ShipType<LunarModule, ApolloSpacecraft> { public: ~LunarModule() { M(); } };
+
+// [TYPE ID DISPATCH] ===================
+// A handler per ship type, indexed by the id of the ship. Finding the handler is a single
+// lookup, no matter how many ship types there are or how deep they derive - whereas a chain
+// of dynamic_casts tries one type after the other and walks the hierarchy for each try.
+// Ship types without a handler get the one of their nearest base that has one, or else the
+// fallback. That is resolved by on() for all ship types known so far; ship types seen for
+// the first time after the last on() walk up their parents on every call.
+template <typename Rock>
+class ShipDispatch {
+public:
+    typedef void (*Handler)(Rock *, SpaceShip *);
+
+    explicit ShipDispatch(Handler fallback) : fallback(fallback) {}
+
+    template <typename Ship>
+    void on(Handler handler) {
+        size_t id = ship_id<Ship>();
+        if (id >= registered.size()) { registered.resize(id + 1, nullptr); }
+        registered[id] = handler;
+        resolve();
+    }
+
+    void operator()(Rock *rock, SpaceShip *ship) const {
+        int id = ship->id();
+        while (id >= static_cast<int>(handlers.size())) { id = ShipTypes::parent(id); }
+        (id >= 0 ? handlers[id] : fallback)(rock, ship);
+    }
+
+private:
+    // parents come before their subclasses, so a single pass sees every parent resolved
+    void resolve() {
+        handlers.resize(ShipTypes::count());
+        for (size_t id = 0; id < handlers.size(); id++) {
+            int parent = ShipTypes::parent(id);
+            if (id < registered.size() && registered[id]) { handlers[id] = registered[id]; }
+            else { handlers[id] = parent >= 0 ? handlers[parent] : fallback; }
+        }
+    }
+
+    Handler fallback;
+    std::vector<Handler> registered; // by on(), nullptr where there is none
+    std::vector<Handler> handlers;   // resolved for every ship type
 };
-class ApolloSpacecraft : public SpaceShip { ~ApolloSpacecraft() { M(); } };
+// ===================
 
 class Asteroid {
 public:
-    virtual void CollideWith(SpaceShip *target) const { 
-        M(); 
+    virtual void CollideWith(SpaceShip *target) const {
+        M();
 
         if (ApolloSpacecraft *a = dynamic_cast<ApolloSpacecraft *>(target)) { this->CollideWith(a); }
         else { /* invalid spaceship, default collision */ }
 
     }
+
+    // the same collision without a cast: one lookup by the id of target
+    void CollideWithIndexed(SpaceShip *target) const {
+        M();
+        dispatch()(this, target);
+    }
+
     virtual ~Asteroid() { M(); }
 
 protected:
-    virtual void CollideWith(ApolloSpacecraft *) const { M(); } 
+    virtual void CollideWith(ApolloSpacecraft *) const { M(); }
+
+private:
+    static const ShipDispatch<const Asteroid> &dispatch() {
+        static const ShipDispatch<const Asteroid> table = [] {
+            ShipDispatch<const Asteroid> t([](const Asteroid *, SpaceShip *) { /* invalid spaceship, default collision */ });
+            t.on<ApolloSpacecraft>([](const Asteroid *a, SpaceShip *s) { a->CollideWith(static_cast<ApolloSpacecraft *>(s)); });
+            return t;
+        }();
+        return table;
+    }
+};
+
+// [BENCHMARK] ===================
+// N ship types, each counting its hits, once found by a chain of dynamic_casts (as in
+// Asteroid::CollideWith) and once by ShipDispatch. Either wide, Probe<0> ... Probe<N - 1> all
+// derive from SpaceShip, or deep, Deep<I> derives from Deep<I - 1>. The chain tries the most
+// derived type first, so a Deep<I> is only taken for a Deep<I> and not for its subclasses.
+template <int I>
+class Probe : public ShipType<Probe<I>> {};
+
+template <int I>
+class Deep : public ShipType<Deep<I>, Deep<I - 1>> {};
+
+template <>
+class Deep<0> : public ShipType<Deep<0>> {};
+
+struct Hits {
+    static const int max_types = 50;
+    long count[max_types];
+};
+
+template <template <int> class Ship, int I>
+struct CastChain {
+    static void collide(Hits *hits, SpaceShip *ship) {
+        if (dynamic_cast<Ship<I> *>(ship)) { hits->count[I]++; }
+        else { CastChain<Ship, I - 1>::collide(hits, ship); }
+    }
+};
+
+template <template <int> class Ship>
+struct CastChain<Ship, -1> {
+    static void collide(Hits *, SpaceShip *) {}
+};
+
+template <int I>
+void hit(Hits *hits, SpaceShip *) { hits->count[I]++; }
+
+template <template <int> class Ship, int I>
+struct Handlers {
+    static void add(ShipDispatch<Hits> &table) {
+        table.on<Ship<I>>(hit<I>);
+        Handlers<Ship, I - 1>::add(table);
+    }
+    static SpaceShip *make(int i) { return i == I ? new Ship<I>{} : Handlers<Ship, I - 1>::make(i); }
+};
+
+template <template <int> class Ship>
+struct Handlers<Ship, -1> {
+    static void add(ShipDispatch<Hits> &) {}
+    static SpaceShip *make(int) { return nullptr; }
 };
 
+template <template <int> class Ship, int N>
+void benchmark_ship_types(const char *shape, size_t n) {
+    static_assert(N >= 1 && N <= Hits::max_types, "Hits counts up to 50 ship types");
+
+    std::mt19937 random(N);
+    std::vector<SpaceShip *> ships;
+    for (size_t i = 0; i < 1000; i++) { ships.push_back(Handlers<Ship, N - 1>::make(random() % N)); }
+
+    std::vector<size_t> order(n);
+    for (size_t &o : order) { o = random() % ships.size(); }
+
+    ShipDispatch<Hits> table([](Hits *, SpaceShip *) {});
+    Handlers<Ship, N - 1>::add(table);
+
+    typedef std::chrono::steady_clock Clock;
+    Hits by_cast = {}, by_table = {};
+
+    Clock::time_point start = Clock::now();
+    for (size_t o : order) { CastChain<Ship, N - 1>::collide(&by_cast, ships[o]); }
+    double cast = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    start = Clock::now();
+    for (size_t o : order) { table(&by_table, ships[o]); }
+    double indexed = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+    bool same = true;
+    for (int i = 0; i < N; i++) { same = same && by_cast.count[i] == by_table.count[i]; }
+
+    std::cout << N << " ship types, " << shape << ": dynamic_cast chain " << cast << " ns, table " << indexed << " ns"
+              << (same ? "" : " (hits differ!)") << std::endl;
+
+    for (SpaceShip *s : ships) { delete s; }
+}
+// ===================
+
 int main() {
     Asteroid *asteroid = new Asteroid{};
     SpaceShip *target = new ApolloSpacecraft{};
 
     asteroid->CollideWith(target);
+    asteroid->CollideWithIndexed(target);
+
+    delete target;
+
+    target = new LunarModule{};
+    asteroid->CollideWith(target);
+    asteroid->CollideWithIndexed(target);
 
     delete target;
     delete asteroid;
-}
\ No newline at end of file
+
+    trace = false;
+    std::cout << std::endl;
+    const size_t n = 1000000;
+    benchmark_ship_types<Probe, 1>("wide", n);
+    benchmark_ship_types<Probe, 2>("wide", n);
+    benchmark_ship_types<Probe, 5>("wide", n);
+    benchmark_ship_types<Probe, 10>("wide", n);
+    benchmark_ship_types<Probe, 20>("wide", n);
+    benchmark_ship_types<Probe, 50>("wide", n);
+    benchmark_ship_types<Deep, 5>("deep", n);
+    benchmark_ship_types<Deep, 10>("deep", n);
+    benchmark_ship_types<Deep, 20>("deep", n);
+}
@@ -1,36 +1,366 @@
 #include <iostream>
 #include <typeinfo>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <cassert>
 
-#define M(m) std::cout << m << std::endl;
+// Testing in terminal:
+// g++ -o visitor -std=c++11 -O2 -DNDEBUG -pthread -Wall -Wextra visitor.cpp && ./visitor
+// (without -DNDEBUG, the batch engine asserts that every pair landed in the right bucket)
+
+static bool trace = true;
+
+#define M(m) do { if (trace) { std::cout << m << std::endl; } } while (0)
 #define SEPERATOR() std::cout << std::endl;
 
 class SpaceShip;
 class ApolloSpacecraft;
 
+// Dense ids of the dynamic types. Every class passes its own to the protected constructor of
+// its base, so the batch engine below can bucket objects by reading a field - no virtual call.
+enum ShipKind { SPACESHIP, APOLLO_SPACECRAFT, SHIP_KINDS };
+enum AsteroidKind { ASTEROID, EXPLODING_ASTEROID, ASTEROID_KINDS };
+
 class Asteroid {
 public:
-    virtual void CollideWith(SpaceShip *) const { M(__PRETTY_FUNCTION__); }
-    virtual void CollideWith(ApolloSpacecraft *) const { M(__PRETTY_FUNCTION__); }
+    Asteroid() : kind(ASTEROID) {}
+
+    virtual void CollideWith(SpaceShip *) const;
+    virtual void CollideWith(ApolloSpacecraft *) const;
     virtual ~Asteroid() { M(__PRETTY_FUNCTION__); }
+
+    const int kind;
+
+protected:
+    explicit Asteroid(int kind) : kind(kind) {}
 };
 
 class ExplodingAsteroid : public Asteroid {
 public:
-    virtual void CollideWith(SpaceShip *) const override { M(__PRETTY_FUNCTION__); }
-    virtual void CollideWith(ApolloSpacecraft *) const override { M(__PRETTY_FUNCTION__); }
+    ExplodingAsteroid() : Asteroid(EXPLODING_ASTEROID) {}
+
+    virtual void CollideWith(SpaceShip *) const override;
+    virtual void CollideWith(ApolloSpacecraft *) const override;
 };
 
 class SpaceShip {
 public:
+    SpaceShip() : kind(SPACESHIP) {}
+
     // IMPORTANT method
     virtual void CollideWith(Asteroid *a) { a->CollideWith(this); }
     virtual ~SpaceShip() { M(__PRETTY_FUNCTION__); }
+
+    const int kind;
+    long damage = 0;
+
+protected:
+    explicit SpaceShip(int kind) : kind(kind) {}
 };
 class ApolloSpacecraft : public SpaceShip {
+public:
+    ApolloSpacecraft() : SpaceShip(APOLLO_SPACECRAFT) {}
+
+private:
     // IMPORTANT method
     virtual void CollideWith(Asteroid *a) { a->CollideWith(this); }
 };
 
+void Asteroid::CollideWith(SpaceShip *s) const { M(__PRETTY_FUNCTION__); s->damage += 1; }
+void Asteroid::CollideWith(ApolloSpacecraft *s) const { M(__PRETTY_FUNCTION__); s->damage += 2; }
+void ExplodingAsteroid::CollideWith(SpaceShip *s) const { M(__PRETTY_FUNCTION__); s->damage += 10; }
+void ExplodingAsteroid::CollideWith(ApolloSpacecraft *s) const { M(__PRETTY_FUNCTION__); s->damage += 5; }
+
+// [BATCH] ===================
+// target->CollideWith(asteroid) costs two indirect calls per pair, and with the types of the
+// pairs mixed randomly, both are hard to predict. When millions of pairs collide per tick,
+// it pays off to sort them first:
+//   1. bucket the pairs by (dynamic ship type, dynamic asteroid type) as they are added,
+//      looking at the kind fields only
+//   2. for every bucket, run one loop which calls the matching overload directly,
+//      e.g. ExplodingAsteroid::CollideWith(ApolloSpacecraft *) - statically bound and inlinable
+// That is one dispatch per bucket instead of two per pair.
+class CollisionBatch {
+public:
+    void add(SpaceShip *ship, Asteroid *asteroid) {
+        buckets[ship->kind * ASTEROID_KINDS + asteroid->kind].push_back(Pair{ship, asteroid});
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (const std::vector<Pair> &b : buckets) { n += b.size(); }
+        return n;
+    }
+
+    // collides all the added pairs and empties the batch (keeping the memory for the next tick)
+    void run() {
+        for (int b = 0; b < BUCKETS; b++) {
+            handlers[b](buckets[b].data(), buckets[b].size());
+            buckets[b].clear();
+        }
+    }
+
+private:
+    struct Pair {
+        SpaceShip *ship;
+        Asteroid *asteroid;
+    };
+
+    static const int BUCKETS = SHIP_KINDS * ASTEROID_KINDS;
+
+    // The kind has to be the exact dynamic type, then the casts are safe and the qualified call
+    // Rock::CollideWith skips the virtual dispatch. Overload resolution on Ship * picks
+    // the same method the visitor would have ended up in.
+    //
+    // A subclass which doesn't pass its own kind (and has no handler here) inherits the kind
+    // of its base, and the qualified call would silently skip its overrides - so check it.
+    template <typename Ship, typename Rock>
+    static void collide(const Pair *p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            assert(typeid(*p[i].ship) == typeid(Ship) && "ship type without its own kind / handler");
+            assert(typeid(*p[i].asteroid) == typeid(Rock) && "asteroid type without its own kind / handler");
+            static_cast<const Rock *>(p[i].asteroid)->Rock::CollideWith(static_cast<Ship *>(p[i].ship));
+        }
+    }
+
+    typedef void (*Handler)(const Pair *, size_t);
+    static const Handler handlers[BUCKETS];
+
+    std::vector<Pair> buckets[BUCKETS];
+};
+
+// indexed by [ship kind][asteroid kind], flattened
+const CollisionBatch::Handler CollisionBatch::handlers[CollisionBatch::BUCKETS] = {
+    collide<SpaceShip, Asteroid>,
+    collide<SpaceShip, ExplodingAsteroid>,
+    collide<ApolloSpacecraft, Asteroid>,
+    collide<ApolloSpacecraft, ExplodingAsteroid>,
+};
+// ===================
+
+// [BROAD PHASE] ===================
+// Which ships hit which asteroids? Testing every pair is O(n^2) - hopeless for 10^6 objects.
+// Instead, the asteroids are sorted into a uniform grid whose cells are at least as wide as
+// the largest possible collision distance. Then a ship can only hit asteroids in its own cell
+// and the 8 cells around it.
+//
+// Positions are kept as a structure of arrays, separate from the objects: the grid scans
+// x, y and radius only, and never touches the (scattered) ships and asteroids themselves.
+struct Positions {
+    std::vector<float> x, y, radius;
+
+    void add(float px, float py, float r) {
+        x.push_back(px);
+        y.push_back(py);
+        radius.push_back(r);
+    }
+
+    size_t size() const { return x.size(); }
+    float maxRadius() const { return radius.empty() ? 0 : *std::max_element(radius.begin(), radius.end()); }
+};
+
+// The square world [0, world) x [0, world), positions outside are clamped to the border cells.
+// The cells are at least reach wide, but there are never more than about one per item -
+// point-sized objects (reach 0) would otherwise ask for an endless number of cells.
+class UniformGrid {
+public:
+    UniformGrid(const Positions &p, float world, float reach)
+        : side(sideFor(p.size(), world, reach)), cell(world > 0 ? world / side : 1),
+          start(size_t(side) * side + 1, 0), items(p.size()) {
+        // counting sort of the items by cell: start[c] .. start[c + 1] are the items of cell c
+        for (size_t i = 0; i < p.size(); i++) { start[index(p.x[i], p.y[i]) + 1]++; }
+        for (size_t c = 0; c + 1 < start.size(); c++) { start[c + 1] += start[c]; }
+
+        std::vector<size_t> next(start.begin(), start.end() - 1);
+        for (size_t i = 0; i < p.size(); i++) { items[next[index(p.x[i], p.y[i])]++] = i; }
+    }
+
+    // calls f(item) for every item in the cell of (x, y) and the cells around it
+    template <typename F>
+    void near(float x, float y, F f) const {
+        int cx = coordinate(x), cy = coordinate(y);
+        for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, side - 1); gy++) {
+            for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, side - 1); gx++) {
+                size_t c = size_t(gy) * side + gx;
+                for (size_t k = start[c]; k < start[c + 1]; k++) { f(items[k]); }
+            }
+        }
+    }
+
+private:
+    static int sideFor(size_t items, float world, float reach) {
+        double most = std::max(1.0, std::floor(std::sqrt(double(items))));
+        double fit = reach > 0 ? std::floor(double(world) / reach) : most;
+        return int(std::max(1.0, std::min(fit, most)));
+    }
+
+    // clamped before the conversion, which would overflow for positions far outside
+    int coordinate(float v) const {
+        float c = v / cell;
+        return c >= 1 ? (c < side ? int(c) : side - 1) : 0;
+    }
+    size_t index(float x, float y) const { return size_t(coordinate(y)) * side + coordinate(x); }
+
+    int side;
+    float cell;
+    std::vector<size_t> start;
+    std::vector<size_t> items;
+};
+
+// Collides every ship with every asteroid it overlaps and returns the number of collisions.
+// The ships are split into one chunk per thread. Each thread queries the grid for its ships
+// and collides the pairs it found through its own CollisionBatch. A ship belongs to exactly
+// one thread, so the ship side of CollideWith (the damage) is never written concurrently.
+size_t collide_overlapping(const std::vector<SpaceShip *> &ships, const Positions &ship_pos,
+                           const std::vector<Asteroid *> &asteroids, const Positions &asteroid_pos,
+                           float world, unsigned threads) {
+    const UniformGrid grid(asteroid_pos, world, ship_pos.maxRadius() + asteroid_pos.maxRadius());
+
+    threads = std::max(1u, threads);
+    std::vector<size_t> found(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threads; t++) {
+        size_t begin = ships.size() * t / threads, end = ships.size() * (t + 1) / threads;
+
+        workers.emplace_back([&, t, begin, end] {
+            CollisionBatch batch;
+            for (size_t s = begin; s < end; s++) {
+                float x = ship_pos.x[s], y = ship_pos.y[s], r = ship_pos.radius[s];
+                grid.near(x, y, [&](size_t a) {
+                    float dx = asteroid_pos.x[a] - x, dy = asteroid_pos.y[a] - y, d = asteroid_pos.radius[a] + r;
+                    if (dx * dx + dy * dy < d * d) { batch.add(ships[s], asteroids[a]); }
+                });
+            }
+            found[t] = batch.size();
+            batch.run();
+        });
+    }
+    for (std::thread &w : workers) { w.join(); }
+
+    size_t total = 0;
+    for (size_t f : found) { total += f; }
+    return total;
+}
+// ===================
+
+void benchmark_batch(size_t n) {
+    const size_t objects = 1000;
+    std::mt19937 random(42);
+
+    std::vector<SpaceShip *> ships;
+    std::vector<Asteroid *> asteroids;
+    for (size_t i = 0; i < objects; i++) {
+        if (random() % 2) { ships.push_back(new SpaceShip{}); } else { ships.push_back(new ApolloSpacecraft{}); }
+        if (random() % 2) { asteroids.push_back(new Asteroid{}); } else { asteroids.push_back(new ExplodingAsteroid{}); }
+    }
+
+    std::vector<size_t> ship_of(n), asteroid_of(n);
+    for (size_t i = 0; i < n; i++) {
+        ship_of[i] = random() % objects;
+        asteroid_of[i] = random() % objects;
+    }
+
+    auto total_damage = [&] {
+        long sum = 0;
+        for (SpaceShip *s : ships) { sum += s->damage; }
+        return sum;
+    };
+
+    CollisionBatch batch;
+    auto per_pair_tick = [&] {
+        for (size_t i = 0; i < n; i++) { ships[ship_of[i]]->CollideWith(asteroids[asteroid_of[i]]); }
+    };
+    auto batched_tick = [&] {
+        for (size_t i = 0; i < n; i++) { batch.add(ships[ship_of[i]], asteroids[asteroid_of[i]]); }
+        batch.run();
+    };
+
+    // the first tick grows the buckets, the following ticks reuse their memory
+    batched_tick();
+
+    typedef std::chrono::steady_clock Clock;
+
+    long before = total_damage();
+    Clock::time_point start = Clock::now();
+    per_pair_tick();
+    double per_pair = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    long per_pair_damage = total_damage() - before;
+
+    before = total_damage();
+    start = Clock::now();
+    batched_tick();
+    double batched = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    long batched_damage = total_damage() - before;
+
+    std::cout << n << " collisions" << std::endl;
+    std::cout << "per pair (visitor):  " << per_pair << " ms, damage " << per_pair_damage << std::endl;
+    std::cout << "batched (add + run): " << batched << " ms, damage " << batched_damage << std::endl;
+
+    for (SpaceShip *s : ships) { delete s; }
+    for (Asteroid *a : asteroids) { delete a; }
+}
+
+void benchmark_broad_phase(size_t objects) {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> radius(0.5f, 1.5f);
+
+    // about 1.5 asteroids within reach of every ship
+    const float world = std::sqrt(float(objects)) * 3;
+    std::uniform_real_distribution<float> coordinate(0, world);
+
+    std::vector<SpaceShip *> ships;
+    std::vector<Asteroid *> asteroids;
+    Positions ship_pos, asteroid_pos;
+    for (size_t i = 0; i < objects / 2; i++) {
+        if (random() % 2) { ships.push_back(new SpaceShip{}); } else { ships.push_back(new ApolloSpacecraft{}); }
+        ship_pos.add(coordinate(random), coordinate(random), radius(random));
+        if (random() % 2) { asteroids.push_back(new Asteroid{}); } else { asteroids.push_back(new ExplodingAsteroid{}); }
+        asteroid_pos.add(coordinate(random), coordinate(random), radius(random));
+    }
+
+    auto total_damage = [&] {
+        long sum = 0;
+        for (SpaceShip *s : ships) { sum += s->damage; }
+        return sum;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned threads : {1u, hardware}) {
+        long before = total_damage();
+        Clock::time_point start = Clock::now();
+        size_t pairs = collide_overlapping(ships, ship_pos, asteroids, asteroid_pos, world, threads);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::cout << objects << " objects, " << threads << " thread(s): " << pairs << " collisions in "
+                  << ms << " ms, damage " << total_damage() - before << std::endl;
+        if (threads == hardware) { break; }
+    }
+
+    // the grid has to find exactly the pairs of the O(n^2) test - checked on a small world
+    if (objects <= 10000) {
+        size_t pairs = 0;
+        for (size_t s = 0; s < ships.size(); s++) {
+            for (size_t a = 0; a < asteroids.size(); a++) {
+                float dx = asteroid_pos.x[a] - ship_pos.x[s], dy = asteroid_pos.y[a] - ship_pos.y[s];
+                float d = asteroid_pos.radius[a] + ship_pos.radius[s];
+                if (dx * dx + dy * dy < d * d) { pairs++; }
+            }
+        }
+        std::cout << objects << " objects, all pairs: " << pairs << " collisions" << std::endl;
+    }
+
+    for (SpaceShip *s : ships) { delete s; }
+    for (Asteroid *a : asteroids) { delete a; }
+}
+
 int main() {
     SpaceShip *target = new ApolloSpacecraft{};
     Asteroid *asteroid = new ExplodingAsteroid{};
@@ -43,9 +373,27 @@ int main() {
     // In order to resolve target to his dynamic type, we must create another dynamic dispatch.
     // This is done by using a visitor pattern example. Other examples would work as well (like with dynamic casting).
     // Here, target resolves dynamically to ApolloSpacecraft::CollideWith and inside of this method,
-    // a (from static type Asteroid, but from dynamic type ExplodingAsteroid) resolves again correctly to 
+    // a (from static type Asteroid, but from dynamic type ExplodingAsteroid) resolves again correctly to
     // ExplodingAsteroid::CollideWith, passing this which is a pointer to ApolloSpacecraft as argument
-    // meaning 
+    // meaning
     //      ExplodingAsteroid::CollideWith(ApolloSpacecraft *) is the correct call.
     target->CollideWith(asteroid);
-}
\ No newline at end of file
+    SEPERATOR();
+
+    // The same collision, through the batch engine: the pair lands in the
+    // (ApolloSpacecraft, ExplodingAsteroid) bucket and ends up in the same method.
+    CollisionBatch batch;
+    batch.add(target, asteroid);
+    batch.run();
+    SEPERATOR();
+
+    trace = false;
+    delete target;
+    delete asteroid;
+
+    benchmark_batch(5000000);
+    SEPERATOR();
+
+    benchmark_broad_phase(10000);
+    benchmark_broad_phase(1000000);
+}
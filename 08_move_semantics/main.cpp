@@ -1,4 +1,20 @@
 #include <iostream>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <cstring>
+#include <cassert>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Testing in terminal:
+// g++ -o main -std=c++17 -Wall -Wextra -pedantic -pthread main.cpp && ./main
 
 #define M() std::cout << __PRETTY_FUNCTION__ << std::endl;
 #define SEPERATOR() std::cout << std::endl;
@@ -18,23 +34,230 @@ int getFoo() { return 42; }
 // Move semantics allows an object, under certain conditions, to take ownership of some other object's external resources
 //      Turning expensive copies into cheap moves
 
-class Intvec
+// [STATISTICS] ===================
+// Printing __PRETTY_FUNCTION__ on every construction, copy and move is nice to learn what
+// happens when, but useless under load. Instead, Intvec counts these events.
+//
+// Every thread counts into its own thread_local set of counters (no lock, no shared
+// cache line), intvec_stats() sums them up on demand. So one can check even in a
+// production build, whether a hot path really moves instead of calling operator=(const Intvec&).
+//
+// Build with -DINTVEC_STATS=0 and the counting is compiled out entirely.
+#ifndef INTVEC_STATS
+#define INTVEC_STATS 1
+#endif
+
+enum class IntvecEvent {
+    constructions,
+    copy_constructions,
+    copy_assignments,
+    move_constructions,
+    move_assignments,
+    expression_assignments,
+    shared_copies,
+    detaches,
+    destructions,
+    allocations,
+    allocated_bytes,
+    count
+};
+
+const size_t intvec_events = static_cast<size_t>(IntvecEvent::count);
+
+const char *to_string(IntvecEvent e) {
+    static const char *names[] = {
+        "constructions", "copy constructions", "copy assignments", "move constructions",
+        "move assignments", "expression assignments", "shared copies", "detaches", "destructions", "allocations", "allocated bytes"
+    };
+    return names[static_cast<size_t>(e)];
+}
+
+struct IntvecStats
+{
+    uint64_t counts[intvec_events] = {};
+
+    uint64_t operator[](IntvecEvent e) const { return counts[static_cast<size_t>(e)]; }
+
+    IntvecStats operator-(const IntvecStats &other) const {
+        IntvecStats delta;
+        for (size_t e = 0; e < intvec_events; e++) { delta.counts[e] = counts[e] - other.counts[e]; }
+        return delta;
+    }
+};
+
+// only the events which did happen
+std::ostream &operator<<(std::ostream &out, const IntvecStats &stats) {
+    const char *separator = "";
+    for (size_t e = 0; e < intvec_events; e++) {
+        if (stats.counts[e] == 0) { continue; }
+        out << separator << to_string(static_cast<IntvecEvent>(e)) << ": " << stats.counts[e];
+        separator = ", ";
+    }
+    return out;
+}
+
+class IntvecCounters
 {
 public:
-    explicit Intvec(size_t num = 0) : m_size(num), m_data(new int[m_size]) { M(); }
+    // Only the owning thread writes its counters. A relaxed load + store is a plain
+    // increment on every common platform, atomic only so that intvec_stats() may read them.
+    static void count(IntvecEvent e, uint64_t n = 1) {
+        std::atomic<uint64_t> &c = local().counts[static_cast<size_t>(e)];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
 
-    ~Intvec() {
-        M();
-        if (m_data) {
-            delete[] m_data;
-            m_data = 0;
+    static IntvecStats aggregate() {
+        std::lock_guard<std::mutex> guard(registry().lock);
+
+        IntvecStats stats = registry().retired;
+        for (const PerThread *t : registry().threads) {
+            for (size_t e = 0; e < intvec_events; e++) { stats.counts[e] += t->counts[e].load(std::memory_order_relaxed); }
         }
+        return stats;
     }
 
-    Intvec(const Intvec& other) : m_size(other.m_size), m_data(new int[m_size]) {
-        M();
-        for (size_t i = 0; i < m_size; ++i)
-            m_data[i] = other.m_data[i];
+private:
+    struct PerThread {
+        std::atomic<uint64_t> counts[intvec_events] = {};
+
+        PerThread() {
+            std::lock_guard<std::mutex> guard(registry().lock);
+            registry().threads.push_back(this);
+        }
+
+        // a finished thread hands its counts over, so they don't get lost
+        ~PerThread() {
+            std::lock_guard<std::mutex> guard(registry().lock);
+            for (size_t e = 0; e < intvec_events; e++) { registry().retired.counts[e] += counts[e].load(); }
+
+            std::vector<PerThread *> &threads = registry().threads;
+            threads.erase(std::find(threads.begin(), threads.end(), this));
+        }
+    };
+
+    struct Registry {
+        std::mutex lock;
+        std::vector<PerThread *> threads;
+        IntvecStats retired;
+    };
+
+    static Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    static PerThread &local() {
+        thread_local PerThread counters;
+        return counters;
+    }
+};
+
+IntvecStats intvec_stats() { return IntvecCounters::aggregate(); }
+
+#if INTVEC_STATS
+#define INTVEC_COUNT(event) IntvecCounters::count(IntvecEvent::event)
+#define INTVEC_COUNT_N(event, n) IntvecCounters::count(IntvecEvent::event, n)
+#else
+#define INTVEC_COUNT(event) ((void)0)
+#define INTVEC_COUNT_N(event, n) ((void)0)
+#endif
+
+// prints what happened to all Intvecs since the last call
+void report(const char *what) {
+    static IntvecStats last;
+    IntvecStats now = intvec_stats();
+
+    std::cout << "[" << what << "] " << (now - last) << std::endl;
+    last = now;
+}
+// ===================
+
+// [EXPRESSION TEMPLATES] ===================
+// Written naively, a = b + c * d creates a temporary for c * d, then another one for
+// b + (c * d), and copies (or moves) that into a - three passes over memory and two allocations.
+//
+// With expression templates, b + c * d doesn't compute anything. It builds a small object
+// which only describes the computation (its type is roughly Plus<Intvec, Times<Intvec, Intvec>>).
+// Only the assignment a = ... walks over the elements, once, and evaluates
+// b[i] + c[i] * d[i] for each i. No temporaries, one single fused pass.
+//
+// Every expression is evaluated 4 ints at a time (one SSE / NEON register, via the
+// vector extension of gcc and clang), with a scalar loop for the rest.
+typedef int int4 __attribute__((vector_size(16)));
+typedef long long long4 __attribute__((vector_size(32)));
+
+inline int4 load4(const int *p) {
+    int4 v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void store4(int *p, int4 v) { std::memcpy(p, &v, sizeof(v)); }
+
+// CRTP base of everything that can appear in an expression: the vectors themselves,
+// scalars and the (lazy) results of +, - and *.
+template <typename E>
+struct IntvecExpr
+{
+    const E &self() const { return static_cast<const E &>(*this); }
+
+    size_t size() const { return self().size(); }
+    int operator[](size_t i) const { return self()[i]; }
+    int4 load(size_t i) const { return self().load(i); }
+};
+
+// Intvec keeps short vectors in an inline buffer of N ints (small buffer optimization),
+// so creating, copying and growing a vector of up to N elements never touches the heap.
+// Longer vectors get their memory from Allocator, and grow geometrically (x2) on push_back,
+// which makes push_back amortized O(1) with only O(log n) allocations.
+//
+// Because of the inline buffer, a move can only steal the pointer of a heap buffer.
+// Small vectors are moved by copying their (at most N) elements - which is still cheap.
+template <std::size_t N = 16, typename Allocator = std::allocator<int>>
+class BasicIntvec : public IntvecExpr<BasicIntvec<N, Allocator>>
+{
+    static_assert(N > 0, "the inline buffer needs room for at least one element");
+    using traits = std::allocator_traits<Allocator>;
+
+public:
+    using allocator_type = Allocator;
+
+    explicit BasicIntvec(size_t num = 0, const Allocator &alloc = Allocator()) : m_alloc(alloc) {
+        INTVEC_COUNT(constructions);
+        reserve(num);
+        std::fill(m_data, m_data + num, 0);
+        m_size = num;
+    }
+
+    ~BasicIntvec() {
+        INTVEC_COUNT(destructions);
+        release();
+    }
+
+    BasicIntvec(const BasicIntvec& other) :
+            BasicIntvec(other, traits::select_on_container_copy_construction(other.m_alloc)) {}
+
+    // Copies into memory of alloc. Needed for allocators which don't propagate on copy,
+    // e.g. std::pmr::polymorphic_allocator, whose plain copy falls back to the default resource.
+    BasicIntvec(const BasicIntvec& other, const Allocator &alloc) : m_alloc(alloc) {
+        INTVEC_COUNT(copy_constructions);
+        reserve(other.m_size);
+        std::copy(other.m_data, other.m_data + other.m_size, m_data);
+        m_size = other.m_size;
+    }
+
+    // Steals the heap buffer of other, or copies its inline elements.
+    // Either way, other is left behind as a valid, empty vector.
+    BasicIntvec(BasicIntvec &&other) noexcept : m_alloc(std::move(other.m_alloc)) {
+        INTVEC_COUNT(move_constructions);
+        if (other.onHeap()) {
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+        } else {
+            std::copy(other.m_data, other.m_data + other.m_size, m_data);
+        }
+        m_size = other.m_size;
+        other.reset();
     }
 
     // Without a move assignment operator,
@@ -45,20 +268,30 @@ public:
     // will reuslt in:
     // Intvec::Intvec(size_t)
     // Intvec &Intvec::operator=(const Intvec &)
-    // Intvec::Intvec(const Intvec &)
-    // Intvec::~Intvec()
     // Intvec::~Intvec()
     // 
     // Meaning that the rvalue is composed in the constructor, passed to the assignment operator,
-    // THEN a COPY of it is created (of a variable which wont' care about afterwards), and then its contents are swapper.
-    // In the end, the temporary within the assignment operator is destroyed and then the rvalue is destroyed too (it's going out of scope).
+    // THEN its contents are COPIED element by element (of a variable which we won't care about afterwards),
+    // into a buffer which possibly has to be allocated first.
+    // In the end, the rvalue is destroyed (it's going out of scope), together with its buffer.
     //
     // A COPY of a temporary value without a location in the memory is unnecessary and expensive (in terms of performance)
-    Intvec& operator=(const Intvec& other) {
-        M();
-        Intvec tmp(other);
-        std::swap(m_size, tmp.m_size);
-        std::swap(m_data, tmp.m_data);
+    //
+    // The existing buffer is reused whenever it is big enough, a copy only allocates when it has to grow.
+    BasicIntvec& operator=(const BasicIntvec& other) {
+        INTVEC_COUNT(copy_assignments);
+        if (this == &other) { return *this; }
+
+        if (traits::propagate_on_container_copy_assignment::value && m_alloc != other.m_alloc) {
+            release();
+            reset();
+        }
+        if (traits::propagate_on_container_copy_assignment::value) { m_alloc = other.m_alloc; }
+
+        m_size = 0;
+        reserve(other.m_size);
+        std::copy(other.m_data, other.m_data + other.m_size, m_data);
+        m_size = other.m_size;
         return *this;
     }
 
@@ -72,21 +305,630 @@ public:
     // Afterwards, it will be destroyed. No unnecessary copy is created.
     // 
     // The magic of move semantics.
-    Intvec& operator=(Intvec &&other) {
-        M();
-        m_size = other.m_size;
-        m_data = other.m_data;
-        other.m_data = nullptr;
-        
+    //
+    // Our own buffer has to be given back first (otherwise it leaks), and other must be left
+    // in a valid state, with a size that matches its (now empty) buffer.
+    // A heap buffer can only be stolen, if our allocator is able to free it later on.
+    BasicIntvec& operator=(BasicIntvec &&other) noexcept(traits::propagate_on_container_move_assignment::value) {
+        INTVEC_COUNT(move_assignments);
+        if (this == &other) { return *this; }
+
+        bool steal = other.onHeap() &&
+                     (traits::propagate_on_container_move_assignment::value || m_alloc == other.m_alloc);
+
+        if (steal) {
+            release();
+            if (traits::propagate_on_container_move_assignment::value) { m_alloc = std::move(other.m_alloc); }
+
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+        } else {
+            m_size = 0;
+            reserve(other.m_size);
+            std::copy(other.m_data, other.m_data + other.m_size, m_data);
+            m_size = other.m_size;
+            other.release();
+        }
+
+        other.reset();
+        return *this;
+    }
+
+    // Evaluates the whole expression in one pass, see IntvecExpr.
+    template <typename E>
+    BasicIntvec(const IntvecExpr<E> &e, const Allocator &alloc = Allocator()) : m_alloc(alloc) {
+        INTVEC_COUNT(constructions);
+        reserve(e.size());
+        m_size = e.size();
+        evaluate(e);
+    }
+
+    template <typename E>
+    BasicIntvec& operator=(const IntvecExpr<E> &e) {
+        INTVEC_COUNT(expression_assignments);
+        // growing would free our buffer, which the expression might still read from (a = a + b)
+        if (e.size() > m_capacity) { return *this = BasicIntvec(e, m_alloc); }
+
+        m_size = e.size();
+        evaluate(e);
+        return *this;
+    }
+
+    template <typename E>
+    BasicIntvec& operator+=(const IntvecExpr<E> &e) { return *this = *this + e; }
+
+    template <typename E>
+    BasicIntvec& operator-=(const IntvecExpr<E> &e) { return *this = *this - e; }
+
+    BasicIntvec& operator*=(int s) { return *this = *this * s; }
+
+    void reserve(size_t capacity) {
+        if (capacity <= m_capacity) { return; }
+
+        int *data = traits::allocate(m_alloc, capacity);
+        INTVEC_COUNT(allocations);
+        INTVEC_COUNT_N(allocated_bytes, capacity * sizeof(int));
+        std::copy(m_data, m_data + m_size, data);
+        release();
+
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    void push_back(int value) {
+        if (m_size == m_capacity) { reserve(2 * m_capacity); }
+        m_data[m_size++] = value;
+    }
+
+    void clear() { m_size = 0; }
+
+    int &operator[](size_t i) { return m_data[i]; }
+    const int &operator[](size_t i) const { return m_data[i]; }
+
+    int4 load(size_t i) const { return load4(m_data + i); }
+
+    int *data() { return m_data; }
+    const int *data() const { return m_data; }
+
+    int *begin() { return m_data; }
+    int *end() { return m_data + m_size; }
+    const int *begin() const { return m_data; }
+    const int *end() const { return m_data + m_size; }
+
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool onHeap() const { return m_data != m_inline; }
+    allocator_type get_allocator() const { return m_alloc; }
+
+private:
+    template <typename E>
+    void evaluate(const IntvecExpr<E> &e) {
+        const E &expr = e.self();
+        size_t i = 0;
+
+        for (; i + 4 <= m_size; i += 4) { store4(m_data + i, expr.load(i)); }
+        for (; i < m_size; i++) { m_data[i] = expr[i]; }
+    }
+
+    // gives the heap buffer (if any) back to the allocator, leaves m_data dangling
+    void release() {
+        if (onHeap()) { traits::deallocate(m_alloc, m_data, m_capacity); }
+    }
+
+    // back to the empty inline buffer
+    void reset() {
+        m_data = m_inline;
+        m_capacity = N;
+        m_size = 0;
+    }
+
+    Allocator m_alloc;
+    size_t m_size = 0;
+    size_t m_capacity = N;
+    int* m_data = m_inline;
+    int m_inline[N];
+};
+
+using Intvec = BasicIntvec<>;
+
+struct Plus { 
+    static int apply(int a, int b) { return a + b; }
+    static int4 apply(int4 a, int4 b) { return a + b; }
+};
+
+struct Minus { 
+    static int apply(int a, int b) { return a - b; }
+    static int4 apply(int4 a, int4 b) { return a - b; }
+};
+
+struct Times { 
+    static int apply(int a, int b) { return a * b; }
+    static int4 apply(int4 a, int4 b) { return a * b; }
+};
+
+// a node of the expression tree, holds its operands by reference (vectors) or by value (nodes, scalars)
+template <typename E>
+struct ExprStorage { using type = const E &; };
+
+template <typename L, typename R, typename Op>
+class IntvecBinary : public IntvecExpr<IntvecBinary<L, R, Op>>
+{
+public:
+    IntvecBinary(const L &l, const R &r) : l(l), r(r) { assert(l.size() == r.size()); }
+
+    size_t size() const { return l.size(); }
+    int operator[](size_t i) const { return Op::apply(l[i], r[i]); }
+    int4 load(size_t i) const { return Op::apply(l.load(i), r.load(i)); }
+
+private:
+    typename ExprStorage<L>::type l;
+    typename ExprStorage<R>::type r;
+};
+
+template <typename L, typename R, typename Op>
+struct ExprStorage<IntvecBinary<L, R, Op>> { using type = IntvecBinary<L, R, Op>; };
+
+// a scalar, broadcast to whatever size the other operand has
+class IntvecScalar : public IntvecExpr<IntvecScalar>
+{
+public:
+    IntvecScalar(int value, size_t n) : value(value), n(n) {}
+
+    size_t size() const { return n; }
+    int operator[](size_t) const { return value; }
+    int4 load(size_t) const { return int4{value, value, value, value}; }
+
+private:
+    int value;
+    size_t n;
+};
+
+template <>
+struct ExprStorage<IntvecScalar> { using type = IntvecScalar; };
+
+template <typename L, typename R>
+IntvecBinary<L, R, Plus> operator+(const IntvecExpr<L> &l, const IntvecExpr<R> &r) {
+    return IntvecBinary<L, R, Plus>(l.self(), r.self());
+}
+
+template <typename L, typename R>
+IntvecBinary<L, R, Minus> operator-(const IntvecExpr<L> &l, const IntvecExpr<R> &r) {
+    return IntvecBinary<L, R, Minus>(l.self(), r.self());
+}
+
+// element-wise product
+template <typename L, typename R>
+IntvecBinary<L, R, Times> operator*(const IntvecExpr<L> &l, const IntvecExpr<R> &r) {
+    return IntvecBinary<L, R, Times>(l.self(), r.self());
+}
+
+// scale
+template <typename E>
+IntvecBinary<IntvecScalar, E, Times> operator*(int s, const IntvecExpr<E> &e) {
+    return IntvecBinary<IntvecScalar, E, Times>(IntvecScalar(s, e.size()), e.self());
+}
+
+template <typename E>
+IntvecBinary<E, IntvecScalar, Times> operator*(const IntvecExpr<E> &e, int s) {
+    return IntvecBinary<E, IntvecScalar, Times>(e.self(), IntvecScalar(s, e.size()));
+}
+
+// The reductions run directly on the data. Sum and dot accumulate in 64 bit lanes,
+// so that they don't overflow for large vectors.
+inline long long sum(const int *data, size_t n) {
+    const size_t body = n - n % 4;
+    long4 acc = {0, 0, 0, 0};
+    for (size_t i = 0; i < body; i += 4) { acc += __builtin_convertvector(load4(data + i), long4); }
+
+    long long result = acc[0] + acc[1] + acc[2] + acc[3];
+    for (size_t i = body; i < n; i++) { result += data[i]; }
+    return result;
+}
+
+inline long long dot(const int *a, const int *b, size_t n) {
+    const size_t body = n - n % 4;
+    long4 acc = {0, 0, 0, 0};
+    for (size_t i = 0; i < body; i += 4) {
+        acc += __builtin_convertvector(load4(a + i), long4) * __builtin_convertvector(load4(b + i), long4);
+    }
+
+    long long result = acc[0] + acc[1] + acc[2] + acc[3];
+    for (size_t i = body; i < n; i++) { result += static_cast<long long>(a[i]) * b[i]; }
+    return result;
+}
+
+// min (Less = true) or max (Less = false) of n > 0 ints
+template <bool Less>
+int extremum(const int *data, size_t n) {
+    int result = data[0];
+    size_t i = 0;
+
+    if (n >= 4) {
+        int4 best = load4(data);
+        for (i = 4; i + 4 <= n; i += 4) {
+            int4 v = load4(data + i);
+            int4 take = Less ? v < best : v > best; // all bits set where v wins
+            best = (v & take) | (best & ~take);
+        }
+        result = best[0];
+        for (int k = 1; k < 4; k++) { result = Less ? std::min(result, best[k]) : std::max(result, best[k]); }
+    }
+
+    for (; i < n; i++) { result = Less ? std::min(result, data[i]) : std::max(result, data[i]); }
+    return result;
+}
+
+template <std::size_t N, typename A>
+long long sum(const BasicIntvec<N, A> &v) { return sum(v.data(), v.size()); }
+
+template <std::size_t N1, typename A1, std::size_t N2, typename A2>
+long long dot(const BasicIntvec<N1, A1> &a, const BasicIntvec<N2, A2> &b) {
+    assert(a.size() == b.size());
+    return dot(a.data(), b.data(), a.size());
+}
+
+// both need a non-empty vector
+template <std::size_t N, typename A>
+int min(const BasicIntvec<N, A> &v) { return extremum<true>(v.data(), v.size()); }
+
+template <std::size_t N, typename A>
+int max(const BasicIntvec<N, A> &v) { return extremum<false>(v.data(), v.size()); }
+// ===================
+
+// [COPY-ON-WRITE] ===================
+// When the same payload is handed to many readers, which almost never change it,
+// the deep copy of Intvec(const Intvec&) is pure waste.
+//
+// SharedIntvec shares one buffer between all of its copies, together with an atomic
+// reference count. A copy just increments the count, O(1). Only when a copy is about
+// to be changed (non-const operator[], data(), push_back) while others still share the
+// buffer, it detaches and makes its own private copy first.
+//
+// Like std::shared_ptr, different SharedIntvecs sharing a buffer may be used from different
+// threads at the same time, one and the same SharedIntvec may not (unless it's only read).
+//
+// A reference or pointer handed out by the non-const operator[] / data() would write through
+// to every later O(1) copy, so from then on the buffer is unshareable: copies of it are deep.
+//
+// BEWARE: the non-const operator[] detaches (and makes the buffer unshareable) even if it's
+// only used for reading, read through a const SharedIntvec & where possible.
+class SharedIntvec
+{
+public:
+    explicit SharedIntvec(size_t num = 0) : m_buffer(new Buffer(Intvec(num))) {}
+
+    // takes over the buffer of an Intvec without copying it
+    explicit SharedIntvec(Intvec &&vec) : m_buffer(new Buffer(std::move(vec))) {}
+
+    ~SharedIntvec() { release(); }
+
+    SharedIntvec(const SharedIntvec &other) : m_buffer(other.m_buffer) {
+        if (m_buffer && m_buffer->unshareable) {
+            m_buffer = new Buffer(Intvec(other.m_buffer->vec));
+            return;
+        }
+        INTVEC_COUNT(shared_copies);
+        if (m_buffer) { m_buffer->refs.fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    // a moved-from SharedIntvec holds no buffer and behaves like an empty vector
+    SharedIntvec(SharedIntvec &&other) noexcept : m_buffer(other.m_buffer) {
+        INTVEC_COUNT(move_constructions);
+        other.m_buffer = nullptr;
+    }
+
+    SharedIntvec &operator=(const SharedIntvec &other) {
+        SharedIntvec tmp(other);
+        std::swap(m_buffer, tmp.m_buffer);
         return *this;
     }
 
-    int size() const { return m_size; }
+    SharedIntvec &operator=(SharedIntvec &&other) noexcept {
+        INTVEC_COUNT(move_assignments);
+        if (this != &other) {
+            release();
+            m_buffer = other.m_buffer;
+            other.m_buffer = nullptr;
+        }
+        return *this;
+    }
+
+    size_t size() const { return m_buffer ? m_buffer->vec.size() : 0; }
+    long use_count() const { return m_buffer ? m_buffer->refs.load(std::memory_order_relaxed) : 0; }
+
+    // reading never copies
+    const int &operator[](size_t i) const { return m_buffer->vec[i]; }
+    const int *data() const { return m_buffer ? m_buffer->vec.data() : nullptr; }
+    const int *begin() const { return data(); }
+    const int *end() const { return data() + size(); }
+
+    // writing detaches first, handing out a mutable reference also ends the sharing
+    int &operator[](size_t i) { return leak()[i]; }
+    int *data() { return leak().data(); }
+    void push_back(int value) { detach().push_back(value); }
+
+    // Back to a plain Intvec. Moves the buffer out if we are the only owner, copies it otherwise.
+    Intvec toIntvec() && {
+        if (!m_buffer) { return Intvec(); }
+        if (m_buffer->refs.load(std::memory_order_acquire) == 1) {
+            Intvec vec(std::move(m_buffer->vec));
+            release();
+            return vec;
+        }
+
+        Intvec vec(m_buffer->vec);
+        release();
+        return vec;
+    }
+
 private:
-    size_t m_size;
-    int* m_data;
+    struct Buffer {
+        explicit Buffer(Intvec &&vec) : refs(1), vec(std::move(vec)) {}
+
+        std::atomic<long> refs;
+        Intvec vec;
+        bool unshareable = false; // only ever set by the sole owner
+    };
+
+    // After this, we are the only owner of m_buffer and may change it.
+    // acquire: all the writes of other (former) owners to the buffer are visible to us.
+    Intvec &detach() {
+        if (!m_buffer) {
+            m_buffer = new Buffer(Intvec());
+        } else if (m_buffer->refs.load(std::memory_order_acquire) != 1) {
+            INTVEC_COUNT(detaches);
+            Buffer *copy = new Buffer(Intvec(m_buffer->vec));
+            release();
+            m_buffer = copy;
+        }
+        return m_buffer->vec;
+    }
+
+    Intvec &leak() {
+        Intvec &vec = detach();
+        m_buffer->unshareable = true;
+        return vec;
+    }
+
+    // acq_rel: whoever drops the last reference sees all the writes of the others before deleting
+    void release() {
+        if (m_buffer && m_buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) { delete m_buffer; }
+        m_buffer = nullptr;
+    }
+
+    Buffer *m_buffer;
 };
 
+// Several threads keep copying one shared payload, read it and now and then change their
+// copy. The shared payload must stay untouched, and every changed copy must see only its own change.
+void test_shared_intvec(int threads, int iterations) {
+    Intvec payload(1000);
+    for (size_t k = 0; k < payload.size(); k++) { payload[k] = k; }
+    const long long expected = sum(payload);
+
+    const SharedIntvec shared(std::move(payload));
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (int k = 0; k < iterations; k++) {
+                SharedIntvec copy(shared);
+                const SharedIntvec &reader = copy;
+
+                if (sum(reader.data(), reader.size()) != expected) { errors++; }
+
+                if (k % 8 == 0) {
+                    copy[k % copy.size()] += t + 1;
+                    if (sum(reader.data(), reader.size()) != expected + t + 1 || copy.use_count() != 1) { errors++; }
+                }
+
+                // moves hand the buffer on without touching the count
+                SharedIntvec moved(std::move(copy));
+                if (moved.size() != 1000 || copy.size() != 0) { errors++; }
+            }
+        });
+    }
+    for (std::thread &worker : workers) { worker.join(); }
+
+    if (sum(shared.data(), shared.size()) != expected || shared.use_count() != 1) { errors++; }
+
+    // a reference taken before a copy must not write through to the copy
+    SharedIntvec a(shared);
+    int &r = a[0];
+    SharedIntvec b = a;
+    r = 99;
+    if (a[0] != 99 || static_cast<const SharedIntvec &>(b)[0] != 0 || b.use_count() != 1) { errors++; }
+
+    std::cout << "[shared] " << threads << " threads x " << iterations << " copies, errors: " << errors << std::endl;
+}
+// ===================
+
+// Every Intvec above std::allocator gets its memory from the global heap, and with many threads
+// allocating at once, malloc itself becomes a point of contention.
+//
+// An Arena (bump / monotonic allocator) hands out memory by just moving a pointer forward
+// inside a big chunk. Freeing a single allocation does nothing at all, instead the whole
+// arena is reset at once, e.g. at the end of a request. Every thread gets its own arena
+// (thread_arena()), so there is no locking either.
+//
+// BEWARE: after reset(), every object allocated from the arena points to memory which
+// will be handed out again. Destroy (or forget) them before resetting.
+class Arena
+{
+public:
+    explicit Arena(size_t chunk_size = 64 * 1024) : m_chunk_size(chunk_size) {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena() {
+        for (Chunk &chunk : m_chunks) { ::operator delete(chunk.data); }
+    }
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        if (m_chunks.empty() || !fits(m_chunks.back(), bytes, alignment)) { grow(bytes + alignment); }
+
+        Chunk &chunk = m_chunks.back();
+        size_t offset = align(chunk, alignment);
+        chunk.used = offset + bytes;
+        m_allocated += bytes;
+
+        return chunk.data + offset;
+    }
+
+    // single allocations are never given back, see reset()
+    void deallocate(void *, size_t) {}
+
+    // Frees everything at once. Only the biggest chunk is kept, so an arena
+    // which is reset after every request soon doesn't hit the heap any more.
+    void reset() {
+        if (m_chunks.empty()) { return; }
+
+        std::sort(m_chunks.begin(), m_chunks.end(), [](const Chunk &a, const Chunk &b) { return a.size < b.size; });
+        for (size_t i = 0; i + 1 < m_chunks.size(); i++) { ::operator delete(m_chunks[i].data); }
+
+        m_chunks.erase(m_chunks.begin(), m_chunks.end() - 1);
+        m_chunks.back().used = 0;
+        m_allocated = 0;
+    }
+
+    size_t allocated() const { return m_allocated; }
+    size_t chunks() const { return m_chunks.size(); }
+
+private:
+    struct Chunk {
+        char *data;
+        size_t size;
+        size_t used;
+    };
+
+    static size_t align(const Chunk &chunk, size_t alignment) {
+        uintptr_t p = reinterpret_cast<uintptr_t>(chunk.data) + chunk.used;
+        return chunk.used + (alignment - p % alignment) % alignment;
+    }
+
+    static bool fits(const Chunk &chunk, size_t bytes, size_t alignment) {
+        return align(chunk, alignment) + bytes <= chunk.size;
+    }
+
+    // every new chunk is twice as big as the last one
+    void grow(size_t at_least) {
+        size_t size = m_chunks.empty() ? m_chunk_size : 2 * m_chunks.back().size;
+        size = std::max(size, at_least);
+
+        m_chunks.push_back(Chunk{static_cast<char *>(::operator new(size)), size, 0});
+    }
+
+    size_t m_chunk_size;
+    size_t m_allocated = 0;
+    std::vector<Chunk> m_chunks;
+};
+
+Arena &thread_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+// A standard allocator on top of an arena (by default the arena of the calling thread),
+// usable as the Allocator of BasicIntvec. Two of them are equal if they share the arena.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() : m_arena(&thread_arena()) {}
+    explicit ArenaAllocator(Arena &arena) : m_arena(&arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : m_arena(other.arena()) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T *p, size_t n) { m_arena->deallocate(p, n * sizeof(T)); }
+
+    Arena *arena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return m_arena == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return m_arena != other.arena(); }
+
+private:
+    Arena *m_arena;
+};
+
+// The same arena behind the std::pmr interface, so it can be used with
+// std::pmr::polymorphic_allocator (and all the std::pmr containers) as well.
+class ArenaResource : public std::pmr::memory_resource
+{
+public:
+    explicit ArenaResource(Arena &arena = thread_arena()) : m_arena(arena) {}
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override { return m_arena.allocate(bytes, alignment); }
+    void do_deallocate(void *p, size_t bytes, size_t) override { m_arena.deallocate(p, bytes); }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        const ArenaResource *o = dynamic_cast<const ArenaResource *>(&other);
+        return o && &o->m_arena == &m_arena;
+    }
+
+    Arena &m_arena;
+};
+
+using ArenaIntvec = BasicIntvec<16, ArenaAllocator<int>>;
+using PmrIntvec = BasicIntvec<16, std::pmr::polymorphic_allocator<int>>;
+
+// Simulates a number of requests, each of which creates, copies and grows a bunch of
+// scratch vectors. With an arena, the end of a request is a single reset().
+template <typename Vec, typename MakeAllocator, typename EndRequest>
+double run_requests(int requests, MakeAllocator make_allocator, EndRequest end_request) {
+    auto from = std::chrono::steady_clock::now();
+    // volatile, so that the compiler can't throw the copies away
+    volatile size_t checksum = 0;
+
+    for (int r = 0; r < requests; r++) {
+        {
+            std::vector<Vec> scratch;
+            scratch.reserve(64);
+
+            for (int k = 0; k < 64; k++) {
+                scratch.emplace_back(17 + (r * 31 + k * 7) % 500, make_allocator());
+
+                Vec copy(scratch.back(), make_allocator());
+                for (int p = 0; p < 40; p++) { copy.push_back(p); }
+                checksum = checksum + copy.size();
+            }
+        }
+        end_request();
+    }
+
+    auto until = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(until - from).count();
+}
+
+void benchmark_arena(int requests) {
+    double heap = run_requests<Intvec>(requests,
+            [] { return std::allocator<int>(); },
+            [] {});
+    double arena = run_requests<ArenaIntvec>(requests,
+            [] { return ArenaAllocator<int>(); },
+            [] { thread_arena().reset(); });
+
+    ArenaResource resource;
+    double pmr = run_requests<PmrIntvec>(requests,
+            [&] { return std::pmr::polymorphic_allocator<int>(&resource); },
+            [] { thread_arena().reset(); });
+
+    std::cout << requests << " requests with 64 vectors each" << std::endl;
+    std::cout << "new[] / delete[]:     " << heap << "ms" << std::endl;
+    std::cout << "arena:                " << arena << "ms" << std::endl;
+    std::cout << "arena (pmr resource): " << pmr << "ms" << std::endl;
+}
+
 int main() {
     int i = 1337;
     Foo(i);
@@ -96,15 +938,18 @@ int main() {
 
     Intvec a(42);
     Intvec b(1377);
+    report("Intvec a(42); Intvec b(1377)");
     std::cout << "Size of variable intvec1: " << a.size() << std::endl;
     std::cout << "Size of intvec2: " << b.size() << std::endl;
     SEPERATOR();
 
     b = a;
+    report("b = a");
     std::cout << "Size of intvec2: " << b.size() << std::endl;
     SEPERATOR();
 
     a = Intvec(9999);
+    report("a = Intvec(9999)");
     std::cout << "Size of intvec1: " << a.size() << std::endl;
     SEPERATOR();
 
@@ -118,10 +963,53 @@ int main() {
     // Otherwise, it will result in unexpected behaviour. Basically, we would try to access a memory area, which 
     // points to nothing. 
     //
-    // In this case though, as we only swap the contents in Intvec& operator=(Intvec &&other),
-    // a will contain the contents of b. But we don't care anyway.
+    // In this case though, Intvec& operator=(Intvec &&other) leaves a behind as a valid but empty vector.
+    // So a.size() is fine (it's 0), but don't expect anything of the old contents.
     b = std::move(a);
+    report("b = std::move(a)");
     std::cout << "Size of intvec2: " << b.size() << std::endl;
-    // std::cout << "Size of intvec1: " << a.size() << std::endl;
+    std::cout << "Size of intvec1: " << a.size() << std::endl;
+    SEPERATOR();
+
+    // Short vectors live in the inline buffer, no heap allocation at all.
+    // Only once the 17th element is pushed, the vector moves to the heap and doubles from there on.
+    Intvec c;
+    for (int k = 0; k < 100; k++) {
+        c.push_back(k);
+        if (c.size() == c.capacity()) {
+            std::cout << "size: " << c.size() << ", capacity: " << c.capacity() 
+                      << (c.onHeap() ? " (heap)" : " (inline)") << std::endl;
+        }
+    }
+    report("100x c.push_back()");
+    SEPERATOR();
+
+    // a = b + c * d, evaluated in a single pass without any temporary Intvec
+    Intvec v1(1000), v2(1000), v3(1000);
+    for (size_t k = 0; k < v1.size(); k++) { v1[k] = k; v2[k] = 2; v3[k] = 1000 - k; }
+    report("Intvec v1(1000), v2(1000), v3(1000)");
+
+    Intvec v4 = v1 + v2 * v3;
+    v4 -= 3 * v1;
+    report("v4 = v1 + v2 * v3; v4 -= 3 * v1");
+
+    std::cout << "sum: " << sum(v4) << ", dot: " << dot(v1, v3) 
+              << ", min: " << min(v4) << ", max: " << max(v4) << std::endl;
+    SEPERATOR();
+
+    // copies of a SharedIntvec share the buffer until one of them is written to
+    SharedIntvec s1(std::move(v4));
+    SharedIntvec s2 = s1, s3 = s1;
+    report("SharedIntvec s1(std::move(v4)); s2 = s1, s3 = s1");
+    s3[0] = 42;
+    report("s3[0] = 42");
+    std::cout << "use_count: " << s1.use_count() << " / " << s3.use_count() << std::endl;
+
+    test_shared_intvec(8, 20000);
+    report("test_shared_intvec(8, 20000)");
+    SEPERATOR();
+
+    benchmark_arena(20000);
+    report("benchmark_arena(20000)");
     SEPERATOR();
 }
\ No newline at end of file
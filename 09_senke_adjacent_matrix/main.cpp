@@ -1,43 +1,411 @@
 #include <iostream>
 #include <typeinfo>
 #include <vector>
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <initializer_list>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <random>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <iomanip>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace std::chrono;
 
 // Testing in terminal:
-// g++ -o main -std=c++11 -Wall -Wextra -pedantic main.cpp && ./main
+// g++ -o main -std=c++17 -Wall -Wextra -pedantic -pthread main.cpp && ./main
 // g++ -v | Apple LLVM version 8.1.0 (clang-802.0.42)
 using matrix = std::vector<std::vector<int>>;
 
+// A graph which is fixed at compile time. The finders below are constexpr,
+// so for a constexpr fixed_matrix the sink is computed by the compiler:
+//
+//     constexpr fixed_matrix<3> g = {{ {0, 0, 0}, {1, 0, 0}, {1, 1, 0} }};
+//     static_assert(find_universelle_senke_efficient(g).getVertexIndex() == 0, "");
+template <std::size_t N>
+using fixed_matrix = std::array<std::array<int, N>, N>;
+
+// A matrix of std::vector<int> spends 32 bits per edge and one heap allocation per row.
+// For big graphs (n = 100000 means 10^10 edges) this is ~40 GB, which won't fit anywhere.
+//
+// BitMatrix stores one bit per edge in a single contiguous block. Every row is padded
+// to a multiple of 64 bytes, so each row starts on its own cache line.
+// A 100000 x 100000 graph then needs 100000 * 12544 bytes = ~1.25 GB.
+//
+// m[i][j] returns 0 or 1 like the vector based matrix does, so the sink finders
+// below work on both representations without any change.
+class BitMatrix {
+public:
+    using word = std::uint64_t;
+
+    static const std::size_t word_bits = 64;
+    static const std::size_t row_alignment = 64; // bytes, one cache line
+
+    // read-only view on a single row, m[i] yields one of these
+    class Row {
+    public:
+        explicit Row(const word *data) : data(data) {}
+
+        int operator[](std::size_t j) const { return (data[j / word_bits] >> (j % word_bits)) & 1; }
+
+    private:
+        const word *data;
+    };
+
+    // read-only view on a single column, walks down the rows (strided access!)
+    class Column {
+    public:
+        Column(const BitMatrix &m, std::size_t j) : m(m), j(j) {}
+
+        int operator[](std::size_t i) const { return m.get(i, j); }
+        std::size_t size() const { return m.size(); }
+
+    private:
+        const BitMatrix &m;
+        std::size_t j;
+    };
+
+    explicit BitMatrix(std::size_t n = 0) :
+            n(n),
+            row_words(words_for(n)),
+            data(allocate(n * row_words)) {}
+
+    BitMatrix(std::initializer_list<std::initializer_list<int>> rows) : BitMatrix(rows.size()) {
+        std::size_t i = 0;
+        for (auto &row : rows) {
+            std::size_t j = 0;
+            for (int edge : row) { set(i, j++, edge != 0); }
+            i++;
+        }
+    }
+
+    explicit BitMatrix(const matrix &m) : BitMatrix(m.size()) {
+        for (std::size_t i = 0; i < n; i++) {
+            for (std::size_t j = 0; j < n; j++) { set(i, j, m[i][j] != 0); }
+        }
+    }
+
+    BitMatrix(const BitMatrix &other) : BitMatrix(other.n) {
+        if (n > 0) { std::memcpy(data, other.data, bytes()); }
+    }
+
+    BitMatrix(BitMatrix &&other) noexcept : n(other.n), row_words(other.row_words), data(other.data) {
+        other.n = 0;
+        other.row_words = 0;
+        other.data = nullptr;
+    }
+
+    BitMatrix &operator=(BitMatrix other) noexcept {
+        std::swap(n, other.n);
+        std::swap(row_words, other.row_words);
+        std::swap(data, other.data);
+        return *this;
+    }
+
+    ~BitMatrix() { std::free(data); }
+
+    std::size_t size() const { return n; }
+    std::size_t words_per_row() const { return row_words; }
+    std::size_t bytes() const { return n * row_words * sizeof(word); }
+
+    Row operator[](std::size_t i) const { return Row(row(i)); }
+
+    int get(std::size_t i, std::size_t j) const { return Row(row(i))[j]; }
+
+    void set(std::size_t i, std::size_t j, bool edge) {
+        word &w = data[i * row_words + j / word_bits];
+        word mask = word(1) << (j % word_bits);
+
+        if (edge) { w |= mask; } else { w &= ~mask; }
+    }
+
+    // direct access to the packed words of a row, bit j of the row is bit (j % 64) of word (j / 64)
+    const word *row(std::size_t i) const { return data + i * row_words; }
+    word *row(std::size_t i) { return data + i * row_words; }
+
+    Column column(std::size_t j) const { return Column(*this, j); }
+
+private:
+    // round up to whole cache lines, so that every row starts 64 byte aligned
+    static std::size_t words_for(std::size_t n) {
+        const std::size_t line_words = row_alignment / sizeof(word);
+        std::size_t words = (n + word_bits - 1) / word_bits;
+        return (words + line_words - 1) / line_words * line_words;
+    }
+
+    static word *allocate(std::size_t words) {
+        if (words == 0) { return nullptr; }
+
+        // aligned_alloc wants the size to be a multiple of the alignment, which words_for() guarantees
+        void *p = std::aligned_alloc(row_alignment, words * sizeof(word));
+        if (!p) { throw std::bad_alloc(); }
+
+        std::memset(p, 0, words * sizeof(word));
+        return static_cast<word *>(p);
+    }
+
+    std::size_t n;
+    std::size_t row_words;
+    word *data;
+};
+
+// Binary adjacency matrix file, so that a graph doesn't have to be typed into main().
+//
+// The file starts with a fixed header, followed by the rows (or columns, see layout)
+// at data_offset. Every row is padded to row_bytes (a multiple of 64), and data_offset is
+// page aligned, so the rows can be used straight out of a memory mapping.
+//
+// bit_width is 1 (bit-packed, bit j of a row is bit j % 8 of byte j / 8), 8 or 32
+// (one byte / one little-endian int per edge, anything != 0 is an edge).
+//
+// All numbers are stored little-endian. The header is encoded / decoded field by field
+// (encode(), decode()), never written as the raw struct, so neither the endianness nor
+// the padding of the machine matters.
+struct MatrixFileHeader {
+    enum Layout : std::uint32_t { row_major = 0, column_major = 1 };
+    static const std::size_t encoded_size = 48;
+
+    char magic[8];           // "SENKEMTX"
+    std::uint32_t version;   // 1
+    std::uint32_t layout;
+    std::uint32_t bit_width;
+    std::uint32_t reserved;
+    std::uint64_t n;
+    std::uint64_t row_bytes;
+    std::uint64_t data_offset;
+
+    void encode(unsigned char *out) const {
+        std::memcpy(out, magic, sizeof(magic));
+        store(out + 8, version, 4);
+        store(out + 12, layout, 4);
+        store(out + 16, bit_width, 4);
+        store(out + 20, reserved, 4);
+        store(out + 24, n, 8);
+        store(out + 32, row_bytes, 8);
+        store(out + 40, data_offset, 8);
+    }
+
+    static MatrixFileHeader decode(const unsigned char *in) {
+        MatrixFileHeader header;
+        std::memcpy(header.magic, in, sizeof(header.magic));
+        header.version = load(in + 8, 4);
+        header.layout = load(in + 12, 4);
+        header.bit_width = load(in + 16, 4);
+        header.reserved = load(in + 20, 4);
+        header.n = load(in + 24, 8);
+        header.row_bytes = load(in + 32, 8);
+        header.data_offset = load(in + 40, 8);
+        return header;
+    }
+
+private:
+    static void store(unsigned char *out, std::uint64_t value, int bytes) {
+        for (int b = 0; b < bytes; b++) { out[b] = static_cast<unsigned char>(value >> (8 * b)); }
+    }
+
+    static std::uint64_t load(const unsigned char *in, int bytes) {
+        std::uint64_t value = 0;
+        for (int b = 0; b < bytes; b++) { value |= static_cast<std::uint64_t>(in[b]) << (8 * b); }
+        return value;
+    }
+};
+
+static const char matrix_file_magic[8] = {'S', 'E', 'N', 'K', 'E', 'M', 'T', 'X'};
+static const std::uint64_t matrix_file_page = 4096;
+
+// Writes m in the given layout and bit width (bit-packed rows by default).
+void write_matrix_file(const std::string &path, const BitMatrix &m,
+                       MatrixFileHeader::Layout layout = MatrixFileHeader::row_major,
+                       std::uint32_t bit_width = 1) {
+    if (bit_width != 1 && bit_width != 8 && bit_width != 32) { throw std::invalid_argument("unsupported bit width"); }
+
+    MatrixFileHeader header = {};
+    std::memcpy(header.magic, matrix_file_magic, sizeof(header.magic));
+    header.version = 1;
+    header.layout = layout;
+    header.bit_width = bit_width;
+    header.n = m.size();
+    header.row_bytes = ((header.n * bit_width + 7) / 8 + 63) / 64 * 64;
+    header.data_offset = matrix_file_page;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) { throw std::runtime_error("cannot open " + path + " for writing"); }
+
+    // the header, zero padded up to data_offset
+    std::vector<char> head(header.data_offset, 0);
+    header.encode(reinterpret_cast<unsigned char *>(head.data()));
+    out.write(head.data(), head.size());
+
+    // byte by byte, so the file doesn't depend on the endianness of the machine writing it
+    std::vector<char> row(header.row_bytes);
+    for (std::size_t i = 0; i < m.size(); i++) {
+        std::fill(row.begin(), row.end(), 0);
+
+        for (std::size_t j = 0; j < m.size(); j++) {
+            bool edge = layout == MatrixFileHeader::column_major ? m.get(j, i) : m.get(i, j);
+            if (!edge) { continue; }
+
+            switch (bit_width) {
+                case 1: row[j / 8] |= static_cast<char>(1 << (j % 8)); break;
+                case 8: row[j] = 1; break;
+                default: row[4 * j] = 1; break;
+            }
+        }
+        out.write(row.data(), row.size());
+    }
+
+    if (!out) { throw std::runtime_error("failed to write " + path); }
+}
+
+// A read-only memory mapping of a matrix file. Nothing is read or copied up front,
+// m[i][j] goes straight to the mapped page, so only the pages holding the rows
+// and columns an algorithm actually touches are ever loaded from disk.
+//
+// find_universelle_senke_efficient only touches O(n) entries, so querying a
+// multi-gigabyte graph costs a few MB of page cache.
+class MappedMatrix {
+public:
+    class Row {
+    public:
+        Row(const MappedMatrix &m, std::size_t i) : m(m), i(i) {}
+
+        int operator[](std::size_t j) const { return m.get(i, j); }
+
+    private:
+        const MappedMatrix &m;
+        std::size_t i;
+    };
+
+    explicit MappedMatrix(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::runtime_error("cannot open " + path); }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < MatrixFileHeader::encoded_size) {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a matrix file");
+        }
+
+        length = st.st_size;
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) { throw std::runtime_error("cannot map " + path); }
+        base = static_cast<const unsigned char *>(p);
+
+        header = MatrixFileHeader::decode(base);
+        try {
+            validate();
+        } catch (...) {
+            ::munmap(const_cast<unsigned char *>(base), length);
+            throw;
+        }
+
+        // no read-ahead, the column accesses jump a whole row ahead each time
+        ::madvise(const_cast<unsigned char *>(base), length, MADV_RANDOM);
+        data = base + header.data_offset;
+    }
+
+    MappedMatrix(const MappedMatrix &) = delete;
+    MappedMatrix &operator=(const MappedMatrix &) = delete;
+
+    ~MappedMatrix() { ::munmap(const_cast<unsigned char *>(base), length); }
+
+    std::size_t size() const { return header.n; }
+    const MatrixFileHeader &getHeader() const { return header; }
+
+    Row operator[](std::size_t i) const { return Row(*this, i); }
+
+    int get(std::size_t i, std::size_t j) const {
+        if (header.layout == MatrixFileHeader::column_major) { std::swap(i, j); }
+        const unsigned char *row = data + i * header.row_bytes;
+
+        switch (header.bit_width) {
+            case 1: return (row[j / 8] >> (j % 8)) & 1;
+            case 8: return row[j] != 0;
+            default: return (row[4 * j] | row[4 * j + 1] | row[4 * j + 2] | row[4 * j + 3]) != 0;
+        }
+    }
+
+private:
+    void validate() const {
+        if (std::memcmp(header.magic, matrix_file_magic, sizeof(header.magic)) != 0 || header.version != 1) {
+            throw std::runtime_error("not a matrix file (bad magic / version)");
+        }
+        if (header.layout != MatrixFileHeader::row_major && header.layout != MatrixFileHeader::column_major) {
+            throw std::runtime_error("unknown matrix layout");
+        }
+        if (header.bit_width != 1 && header.bit_width != 8 && header.bit_width != 32) {
+            throw std::runtime_error("unsupported bit width");
+        }
+        // the finders index with int, and nothing below may overflow: every product is
+        // either bounded first (n * bit_width) or turned into a division
+        if (header.n > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+            throw std::runtime_error("matrix too large");
+        }
+        if (header.row_bytes < (header.n * header.bit_width + 7) / 8 ||
+            header.data_offset < MatrixFileHeader::encoded_size || header.data_offset > length ||
+            (header.n > 0 && header.n > (length - header.data_offset) / header.row_bytes)) {
+            throw std::runtime_error("matrix file is truncated or inconsistent");
+        }
+    }
+
+    MatrixFileHeader header;
+    const unsigned char *base;
+    const unsigned char *data;
+    std::size_t length;
+};
+
 class Result {
 public:
-    Result (int vertex_index, int matrix_accesses) : 
+    constexpr Result (int vertex_index, long long matrix_accesses) : 
             vertex_index(vertex_index), 
             matrix_accesses(matrix_accesses) {}
 
-    int getVertexIndex() const { return vertex_index; }
-    int getMatrixAccesses() const { return matrix_accesses; }
+    constexpr int getVertexIndex() const { return vertex_index; }
+    constexpr long long getMatrixAccesses() const { return matrix_accesses; }
 
 private:
     int vertex_index;
-    int matrix_accesses;
+    // long long, the naive search reads up to 2 * n^2 entries which overflows int for n > 32768
+    long long matrix_accesses;
 };
 
-void print_matrix(matrix &m) {
+template <typename Matrix>
+void print_matrix(const Matrix &m) {
     std::cout << "[";
 
-    for (auto i = m.begin(); i != m.end(); i++) {
+    for (std::size_t i = 0; i < m.size(); i++) {
         std::cout << "[";
 
-        for (auto j = (*i).begin(); j != (*i).end(); j++) {
-            std::cout << *j;
+        for (std::size_t j = 0; j < m.size(); j++) {
+            std::cout << m[i][j];
 
-            if ((j + 1) != (*i).end()) { std::cout << ", "; }
+            if ((j + 1) != m.size()) { std::cout << ", "; }
         }
 
         std::cout << "]";
-        if ((i + 1) != m.end()) { std::cout << std::endl; }
+        if ((i + 1) != m.size()) { std::cout << std::endl; }
     }
     std::cout << "]" << std::endl;
 }
@@ -46,8 +414,11 @@ void print_pair(std::pair<int, int> &p) {
     std::cout << "{" << p.first << ", " << p.second << "}" << std::endl;
 }
 
-Result find_universelle_senke(matrix &m) {
-    int requests = 0;
+// Matrix is either matrix (std::vector<std::vector<int>>) or BitMatrix,
+// anything with size() and m[i][j] in {0, 1} will do.
+template <typename Matrix>
+constexpr Result find_universelle_senke(Matrix &m) {
+    long long requests = 0;
     int n = m.size();
 
     // outer loop = cols
@@ -79,11 +450,12 @@ Result find_universelle_senke(matrix &m) {
 }
 
 // http://www.inf.fu-berlin.de/lehre/SS09/infb/muster03.pdf
-Result find_universelle_senke_efficient(matrix &m) {
+template <typename Matrix>
+constexpr Result find_universelle_senke_efficient(Matrix &m) {
     int row = 0;
     int n = m.size();
 
-    int requests = 0;
+    long long requests = 0;
     
     // iterate over deg outs / represents column
     for (int i = 0; i < n; i++) {
@@ -124,39 +496,768 @@ Result find_universelle_senke_efficient(matrix &m) {
     return Result(row, requests);
 }
 
-void test_find_universelle_senke(matrix &adjacent_matrix) {
-    print_matrix(adjacent_matrix); std::cout << std::endl;
-    
-    // [NORMAL] ===================
+// [SIMD] ===================
+// find_universelle_senke walks m[i][j] column by column. On a row-major matrix every
+// single access jumps to another row (another heap allocation even), which is the
+// worst possible access pattern for the cache.
+//
+// The vectorized variant turns the loops around: for a block of columns it streams
+// through the rows and adds each row slice onto an array of in-degree counters.
+// The rows are read sequentially, and the addition is done 4 (SSE) or 8 (AVX2)
+// columns at a time. Which kernel is used is decided once at run-time, depending on
+// what the CPU supports.
+//
+// The result, including the number of matrix accesses, is the same as the one of
+// find_universelle_senke, which is why it can serve as a drop-in replacement.
+using add_row_kernel = void (*)(const int *row, int *deg_in, std::size_t count);
+
+void add_row_scalar(const int *row, int *deg_in, std::size_t count) {
+    for (std::size_t j = 0; j < count; j++) { deg_in[j] += row[j]; }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+void add_row_sse2(const int *row, int *deg_in, std::size_t count) {
+    std::size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + j));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(deg_in + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(deg_in + j), _mm_add_epi32(d, r));
+    }
+    add_row_scalar(row + j, deg_in + j, count - j);
+}
+
+__attribute__((target("avx2")))
+void add_row_avx2(const int *row, int *deg_in, std::size_t count) {
+    std::size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + j));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(deg_in + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(deg_in + j), _mm256_add_epi32(d, r));
+    }
+    add_row_scalar(row + j, deg_in + j, count - j);
+}
+#endif
+
+add_row_kernel select_add_row_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) { return add_row_avx2; }
+    if (__builtin_cpu_supports("sse2")) { return add_row_sse2; }
+#endif
+    return add_row_scalar;
+}
+
+Result find_universelle_senke_simd(const matrix &m) {
+    // 256 counters = 1 KB, stays in L1 while the rows stream by
+    const std::size_t block = 256;
+    static const add_row_kernel add_row = select_add_row_kernel();
+
+    long long requests = 0;
+    int n = m.size();
+    int deg_in[block];
+
+    for (int from = 0; from < n; from += block) {
+        int count = std::min<int>(block, n - from);
+        std::fill(deg_in, deg_in + count, 0);
+
+        for (int i = 0; i < n; i++) {
+            add_row(m[i].data() + from, deg_in, count);
+        }
+
+        // walk the block in the same order as find_universelle_senke does,
+        // so that the number of accesses matches up to the returned sink
+        for (int j = from; j < from + count; j++) {
+            requests += n;
+
+            if (deg_in[j - from] == n - 1) {
+                int deg_out = 0;
+
+                for (int i = 0; i < n; i++) {
+                    deg_out += m[j][i];
+                    requests++;
+                }
+
+                if (deg_out == 0) {
+                    return Result(j, requests);
+                }
+            }
+        }
+    }
+
+    return Result(-1, requests);
+}
+// ===================
+
+// [SPARSE] ===================
+// Real graphs are mostly sparse, a dense n x n matrix wastes almost all of its bits on zeros.
+// SparseGraph keeps the edges twice in compressed form:
+//   CSR (compressed sparse row):    the sorted successors of every vertex,   for m[i][j]
+//   CSC (compressed sparse column): the sorted predecessors of every vertex, for the in-degree
+// The memory is O(n + |E|) instead of O(n^2).
+//
+// m[i][j] is answered by a binary search in the shorter of both lists, so even the
+// dense finders above work on it (just slower).
+class SparseGraph {
+public:
+    using vertex = std::uint32_t;
+    using edge = std::pair<vertex, vertex>;
+
+    class Row {
+    public:
+        Row(const SparseGraph &g, vertex i) : g(g), i(i) {}
+
+        int operator[](std::size_t j) const { return g.has_edge(i, j); }
+
+    private:
+        const SparseGraph &g;
+        vertex i;
+    };
+
+    SparseGraph(std::size_t n, std::vector<edge> edges) : n(n) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        compress(edges, row_offsets, successors, [](const edge &e) { return e; });
+        compress(edges, column_offsets, predecessors, [](const edge &e) { return edge(e.second, e.first); });
+    }
+
+    explicit SparseGraph(const matrix &m) : SparseGraph(m.size(), edges_of(m)) {}
+
+    std::size_t size() const { return n; }
+    std::size_t edges() const { return successors.size(); }
+    std::size_t bytes() const {
+        return (row_offsets.size() + column_offsets.size()) * sizeof(std::size_t) +
+               (successors.size() + predecessors.size()) * sizeof(vertex);
+    }
+
+    std::size_t out_degree(vertex v) const { return row_offsets[v + 1] - row_offsets[v]; }
+    std::size_t in_degree(vertex v) const { return column_offsets[v + 1] - column_offsets[v]; }
+
+    // sorted successors of v, [begin, end)
+    const vertex *successors_begin(vertex v) const { return successors.data() + row_offsets[v]; }
+    const vertex *successors_end(vertex v) const { return successors.data() + row_offsets[v + 1]; }
+
+    bool has_edge(std::size_t i, std::size_t j) const {
+        if (out_degree(i) <= in_degree(j)) {
+            return std::binary_search(successors_begin(i), successors_end(i), vertex(j));
+        }
+        const vertex *first = predecessors.data() + column_offsets[j];
+        return std::binary_search(first, predecessors.data() + column_offsets[j + 1], vertex(i));
+    }
+
+    Row operator[](std::size_t i) const { return Row(*this, i); }
+
+private:
+    static std::vector<edge> edges_of(const matrix &m) {
+        std::vector<edge> edges;
+        for (std::size_t i = 0; i < m.size(); i++) {
+            for (std::size_t j = 0; j < m.size(); j++) {
+                if (m[i][j]) { edges.push_back(edge(i, j)); }
+            }
+        }
+        return edges;
+    }
+
+    // counting sort of the edges by key(e).first, the targets keep their order within a bucket
+    template <typename Key>
+    void compress(const std::vector<edge> &edges, std::vector<std::size_t> &offsets,
+                  std::vector<vertex> &targets, Key key) {
+        offsets.assign(n + 1, 0);
+        for (const edge &e : edges) { offsets[key(e).first + 1]++; }
+        for (std::size_t v = 0; v < n; v++) { offsets[v + 1] += offsets[v]; }
+
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        targets.resize(edges.size());
+        for (const edge &e : edges) { targets[fill[key(e).first]++] = key(e).second; }
+
+        // the CSC pass gets its edges ordered by source, so every bucket is sorted already
+    }
+
+    std::size_t n;
+    std::vector<std::size_t> row_offsets, column_offsets;
+    std::vector<vertex> successors, predecessors;
+};
+
+// Same elimination idea as find_universelle_senke_efficient, but instead of asking
+// m[row][i] for every single i, the next 1 in the row of the current candidate is
+// looked up directly in its sorted successor list. All the 0s in between are skipped.
+//
+// Each step either moves the candidate forward or ends the scan, so there are at most
+// n steps (each a binary search), and the final check of the candidate is O(1) thanks
+// to the stored degrees. The accesses count the successor lookups plus the two degrees.
+Result find_universelle_senke_sparse(const SparseGraph &g) {
+    int n = g.size();
+    long long requests = 0;
+
+    if (n == 0) { return Result(-1, requests); }
+
+    SparseGraph::vertex row = 0;
+    SparseGraph::vertex i = 0;
+
+    while (i < SparseGraph::vertex(n)) {
+        const SparseGraph::vertex *last = g.successors_end(row);
+        const SparseGraph::vertex *next = std::lower_bound(g.successors_begin(row), last, i);
+        requests++;
+
+        if (next == last) { break; }
+
+        // m[row][*next] == 1, so row can't be a sink and everything before *next was ruled out already
+        row = *next;
+        i = row + 1;
+    }
+
+    requests += 2;
+    if (g.out_degree(row) != 0 || g.in_degree(row) != std::size_t(n - 1)) {
+        return Result(-1, requests);
+    }
+
+    return Result(row, requests);
+}
+
+void test_find_universelle_senke_sparse(std::size_t n) {
+    // a star: every vertex points to the sink, plus a few random edges between the others
+    std::mt19937 random(1337);
+    SparseGraph::vertex sink = random() % n;
+
+    std::vector<SparseGraph::edge> edges;
+    for (SparseGraph::vertex v = 0; v < n; v++) {
+        if (v == sink) { continue; }
+        edges.push_back(SparseGraph::edge(v, sink));
+
+        SparseGraph::vertex w = random() % n;
+        if (w != sink && w != v) { edges.push_back(SparseGraph::edge(v, w)); }
+    }
+
+    SparseGraph graph(n, edges);
+
     high_resolution_clock::time_point senke_from = high_resolution_clock::now();
-    Result senke = find_universelle_senke(adjacent_matrix);
+    Result senke = find_universelle_senke_sparse(graph);
     high_resolution_clock::time_point senke_until = high_resolution_clock::now();
 
-    duration<double, std::nano> senke_dauer = senke_until - senke_from;
-    // ===================
+    duration<double, std::micro> senke_dauer = senke_until - senke_from;
 
-    // [EFFICIENT] ===================
-    high_resolution_clock::time_point senke_efficient_from = high_resolution_clock::now();
-    Result senke_efficient = find_universelle_senke_efficient(adjacent_matrix);
-    high_resolution_clock::time_point senke_efficient_until = high_resolution_clock::now();
+    std::cout << "[sparse] n = " << n << ", |E| = " << graph.edges() << ", " 
+                        << graph.bytes() / (1024 * 1024) << " MB (dicht als BitMatrix: "
+                        << n * ((n + 511) / 512 * 64) / (1024 * 1024) << " MB)" << std::endl;
+    std::cout << "[sparse][" << senke_dauer.count() << "us] universelle Senke " << 
+                        "bei Index: [" << senke.getVertexIndex() << "] (erwartet: [" << sink << "]) "
+                        "mit |Matrixzugriffen| = " << senke.getMatrixAccesses()
+                        << std::endl;
+    std::cout << "======================================================================" << std::endl;
+}
+// ===================
 
-    duration<double, std::nano> senke_efficient_dauer = senke_efficient_until - senke_efficient_from;
-    // ===================
+// [INCREMENTAL] ===================
+// When edges keep streaming in, running find_universelle_senke_efficient again after every
+// batch of updates costs O(n) per query. DynamicSinkGraph keeps the in- and out-degree of
+// every vertex next to the BitMatrix instead, so it always knows the sink.
+//
+// There is at most one universal sink (two sinks would have to point at each other),
+// and inserting or deleting the edge u -> v changes only the degrees of u and v.
+// So after an update only three vertices have to be checked: the old sink, u and v.
+// That is O(1) per update, and the query just returns the stored answer.
+class DynamicSinkGraph {
+public:
+    explicit DynamicSinkGraph(std::size_t n) : m(n), in_degree(n, 0), out_degree(n, 0), sink(n == 1 ? 0 : -1) {}
+
+    explicit DynamicSinkGraph(BitMatrix graph) :
+            m(std::move(graph)),
+            in_degree(m.size(), 0),
+            out_degree(m.size(), 0),
+            sink(-1) {
+        for (std::size_t i = 0; i < m.size(); i++) {
+            for (std::size_t j = 0; j < m.size(); j++) {
+                in_degree[j] += m[i][j];
+                out_degree[i] += m[i][j];
+            }
+        }
+
+        for (std::size_t v = 0; v < m.size(); v++) {
+            if (is_sink(v)) { sink = v; }
+        }
+    }
+
+    // both return false if the edge was already there / wasn't there
+    bool insert_edge(std::size_t u, std::size_t v) { return update(u, v, true); }
+    bool erase_edge(std::size_t u, std::size_t v) { return update(u, v, false); }
+
+    std::size_t size() const { return m.size(); }
+    const BitMatrix &getMatrix() const { return m; }
+
+    // no matrix access needed at all
+    Result universelle_senke() const { return Result(sink, 0); }
+
+private:
+    bool update(std::size_t u, std::size_t v, bool edge) {
+        if (m[u][v] == edge) { return false; }
+        m.set(u, v, edge);
+
+        int delta = edge ? 1 : -1;
+        out_degree[u] += delta;
+        in_degree[v] += delta;
+
+        if (sink != -1 && !is_sink(sink)) { sink = -1; }
+        if (is_sink(u)) { sink = u; }
+        if (is_sink(v)) { sink = v; }
+
+        return true;
+    }
+
+    bool is_sink(std::size_t v) const {
+        return out_degree[v] == 0 && in_degree[v] == m.size() - 1;
+    }
+
+    BitMatrix m;
+    std::vector<std::size_t> in_degree;
+    std::vector<std::size_t> out_degree;
+    int sink;
+};
+
+// Streams random edge updates into a DynamicSinkGraph and compares the maintained answer
+// against find_universelle_senke_efficient on the very same matrix after every batch.
+void test_dynamic_universelle_senke(std::size_t n, int batches, int batch_size) {
+    std::mt19937 random(2017);
+    DynamicSinkGraph graph(n);
+
+    int mismatches = 0, sinks = 0;
+    for (int b = 0; b < batches; b++) {
+        // every batch is biased towards a target vertex, so that sinks come and go
+        std::size_t target = random() % n;
+
+        for (int k = 0; k < batch_size; k++) {
+            std::size_t u = random() % n, v = random() % n;
+            if (u == v) { continue; }
+
+            switch (random() % 4) {
+                case 0: graph.insert_edge(u, v); break;
+                case 1: graph.erase_edge(u, v); break;
+                case 2: graph.insert_edge(u, target); break;
+                default: graph.erase_edge(target, v); break;
+            }
+        }
+
+        Result expected = find_universelle_senke_efficient(graph.getMatrix());
+        Result actual = graph.universelle_senke();
+
+        if (expected.getVertexIndex() != actual.getVertexIndex()) { mismatches++; }
+        if (actual.getVertexIndex() != -1) { sinks++; }
+    }
+
+    std::cout << "[dynamic] n = " << n << ", " << batches << " Batches: " << sinks 
+                        << "x universelle Senke, Abweichungen zu [efficient]: " << mismatches << std::endl;
+    std::cout << "======================================================================" << std::endl;
+}
+// ===================
+
+// [BATCH] ===================
+// Checking tens of thousands of small graphs one by one on a single thread leaves all
+// other cores idle. The batch variant spreads the graphs over a small work-stealing pool.
+//
+// The graphs are cut into chunks which are dealt out round robin to per-thread queues.
+// A thread works through its own queue from the back and, once it runs dry, steals
+// from the front of the others. So a thread which got the big graphs doesn't hold up
+// the whole batch while the rest are already done.
+//
+// Every graph writes its Result into its own slot of the output, hence there is no
+// locking (and no printing) around the results on the hot path.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads) : queues(threads == 0 ? 1 : threads) {}
+
+    // calls task(i) for every i in [0, count), from all threads of the pool
+    template <typename Task>
+    void run(std::size_t count, std::size_t chunk, Task task) {
+        for (std::size_t from = 0, c = 0; from < count; from += chunk, c++) {
+            queues[c % queues.size()].chunks.push_back({from, std::min(from + chunk, count)});
+        }
+
+        std::vector<std::thread> workers;
+        for (std::size_t t = 1; t < queues.size(); t++) {
+            workers.emplace_back([this, t, &task] { work(t, task); });
+        }
+        work(0, task);
+
+        for (std::thread &worker : workers) { worker.join(); }
+    }
+
+    unsigned size() const { return queues.size(); }
+
+private:
+    using Chunk = std::pair<std::size_t, std::size_t>;
+
+    struct Queue {
+        std::mutex lock;
+        std::deque<Chunk> chunks;
+    };
+
+    template <typename Task>
+    void work(std::size_t self, Task &task) {
+        Chunk chunk;
 
-    std::cout << "[normal][" << senke_dauer.count() << "ns] universelle Senke " << 
+        while (pop(self, chunk) || steal(self, chunk)) {
+            for (std::size_t i = chunk.first; i < chunk.second; i++) { task(i); }
+        }
+    }
+
+    bool pop(std::size_t self, Chunk &chunk) {
+        std::lock_guard<std::mutex> guard(queues[self].lock);
+        if (queues[self].chunks.empty()) { return false; }
+
+        chunk = queues[self].chunks.back();
+        queues[self].chunks.pop_back();
+        return true;
+    }
+
+    bool steal(std::size_t self, Chunk &chunk) {
+        for (std::size_t k = 1; k < queues.size(); k++) {
+            Queue &victim = queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+
+            if (!victim.chunks.empty()) {
+                chunk = victim.chunks.front();
+                victim.chunks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;
+};
+
+// Finder is any callable Result(const Matrix &), e.g. a lambda calling find_universelle_senke_efficient
+template <typename Matrix, typename Finder>
+std::vector<Result> find_universelle_senke_batch(const Matrix *graphs, std::size_t count, Finder finder,
+                                                 unsigned threads = std::thread::hardware_concurrency()) {
+    std::vector<Result> results(count, Result(-1, 0));
+
+    WorkStealingPool pool(threads);
+    pool.run(count, 64, [&](std::size_t i) { results[i] = finder(graphs[i]); });
+
+    return results;
+}
+
+template <typename Matrix>
+std::vector<Result> find_universelle_senke_batch(const std::vector<Matrix> &graphs,
+                                                 unsigned threads = std::thread::hardware_concurrency()) {
+    return find_universelle_senke_batch(graphs.data(), graphs.size(),
+                                        [](const Matrix &m) { return find_universelle_senke_efficient(m); },
+                                        threads);
+}
+// ===================
+
+template <typename Matrix>
+void test_find_universelle_senke(Matrix &adjacent_matrix) {
+    print_matrix(adjacent_matrix); std::cout << std::endl;
+
+    // Timing a single call of a 5x5 matrix only measures the clock itself,
+    // see run_benchmarks() (./main --benchmark) for the real numbers.
+    Result senke = find_universelle_senke(adjacent_matrix);
+    Result senke_efficient = find_universelle_senke_efficient(adjacent_matrix);
+
+    std::cout << "[normal] universelle Senke " << 
                         "bei Index: [" << senke.getVertexIndex() << "] " 
                         "mit |Matrixzugriffen| = " << senke.getMatrixAccesses()
                         << std::endl;
 
-    std::cout << "[efficient][" << senke_efficient_dauer.count() << "ns] universelle Senke " << 
+    std::cout << "[efficient] universelle Senke " << 
                         "bei Index: [" << senke_efficient.getVertexIndex() << "] " 
                         "mit |Matrixzugriffen| = " << senke_efficient.getMatrixAccesses() 
                         << std::endl;
 
+    // only for the row-major int matrix, the rows are streamed directly
+    if constexpr (std::is_same<Matrix, matrix>::value) {
+        Result senke_simd = find_universelle_senke_simd(adjacent_matrix);
+
+        std::cout << "[simd] universelle Senke " << 
+                            "bei Index: [" << senke_simd.getVertexIndex() << "] " 
+                            "mit |Matrixzugriffen| = " << senke_simd.getMatrixAccesses()
+                            << std::endl;
+    }
+
+    std::cout << "======================================================================" << std::endl;
+}
+
+// [BENCHMARK] ===================
+// A small in-tree benchmark harness. Every case is warmed up first, then run in
+// rounds of doubling iteration counts until at least min_time has passed.
+// Reported are the time per call, the matrix accesses per call and the throughput.
+//
+// The graphs are stored as BitMatrix, a dense 10^5 x 10^5 graph is 1.25 GB that way.
+//   best:   vertex 0 is the sink, the naive search is done after the first column
+//   worst:  every vertex has in-degree n - 1 and there is no sink,
+//           the naive search reads the whole matrix twice
+//   random: every edge with probability 1/2 and a sink planted at a random vertex
+enum class GraphCase { best, worst, random };
+
+const char *to_string(GraphCase c) {
+    switch (c) {
+        case GraphCase::best: return "best";
+        case GraphCase::worst: return "worst";
+        default: return "random";
+    }
+}
+
+BitMatrix generate_graph(std::size_t n, GraphCase c, unsigned seed) {
+    BitMatrix m(n);
+    std::mt19937_64 random(seed);
+
+    for (std::size_t i = 0; i < n; i++) {
+        BitMatrix::word *row = m.row(i);
+
+        for (std::size_t w = 0; w < (n + BitMatrix::word_bits - 1) / BitMatrix::word_bits; w++) {
+            row[w] = c == GraphCase::best ? 0 : c == GraphCase::worst ? ~BitMatrix::word(0) : random();
+        }
+        m.set(i, i, false);
+    }
+
+    if (c != GraphCase::worst) {
+        std::size_t sink = c == GraphCase::best ? 0 : random() % n;
+        for (std::size_t i = 0; i < n; i++) {
+            m.set(i, sink, i != sink);
+            m.set(sink, i, false);
+        }
+    }
+
+    return m;
+}
+
+struct BenchmarkResult {
+    long long iterations;
+    double ns_per_op;
+    double accesses_per_op;
+};
+
+template <typename Finder>
+BenchmarkResult run_benchmark(Finder finder, double min_time_ms, int warmup) {
+    // the sum keeps the compiler from dropping calls whose result is never used
+    volatile long long sink_sum = 0;
+
+    for (int i = 0; i < warmup; i++) { sink_sum = sink_sum + finder().getVertexIndex(); }
+
+    long long iterations = 1, total_iterations = 0;
+    long long accesses = 0;
+    duration<double, std::nano> total(0);
+
+    while (total.count() < min_time_ms * 1e6) {
+        high_resolution_clock::time_point from = high_resolution_clock::now();
+        for (long long i = 0; i < iterations; i++) {
+            Result r = finder();
+            sink_sum = sink_sum + r.getVertexIndex();
+            accesses += r.getMatrixAccesses();
+        }
+        total += high_resolution_clock::now() - from;
+
+        total_iterations += iterations;
+        iterations *= 2;
+    }
+
+    return BenchmarkResult{total_iterations, total.count() / total_iterations, double(accesses) / total_iterations};
+}
+
+void print_benchmark(const char *name, std::size_t n, GraphCase c, const BenchmarkResult &b) {
+    std::cout << std::left << std::setw(11) << name << std::setw(8) << to_string(c)
+              << std::right << std::setw(8) << n
+              << std::setw(12) << b.iterations
+              << std::setw(16) << std::fixed << std::setprecision(1) << b.ns_per_op
+              << std::setw(16) << std::setprecision(1) << b.accesses_per_op
+              << std::setw(16) << std::setprecision(0) << 1e9 / b.ns_per_op
+              << std::setw(14) << std::setprecision(2) << b.accesses_per_op / b.ns_per_op
+              << std::defaultfloat << std::endl;
+}
+
+void run_benchmarks(std::size_t max_n, double min_time_ms = 200, int warmup = 3) {
+    std::cout << std::left << std::setw(11) << "finder" << std::setw(8) << "graph"
+              << std::right << std::setw(8) << "n" << std::setw(12) << "iterations"
+              << std::setw(16) << "ns/op" << std::setw(16) << "accesses/op"
+              << std::setw(16) << "ops/s" << std::setw(14) << "Gaccesses/s" << std::endl;
+
+    for (std::size_t n = 10; n <= max_n; n *= 10) {
+        for (GraphCase c : {GraphCase::best, GraphCase::random, GraphCase::worst}) {
+            const BitMatrix m = generate_graph(n, c, 42);
+
+            // the naive search reads n^2 entries in the worst case, don't warm that one up
+            int naive_warmup = n >= 10000 ? 0 : warmup;
+
+            print_benchmark("normal", n, c, run_benchmark([&] { return find_universelle_senke(m); },
+                                                          min_time_ms, naive_warmup));
+            print_benchmark("efficient", n, c, run_benchmark([&] { return find_universelle_senke_efficient(m); },
+                                                             min_time_ms, warmup));
+        }
+    }
+}
+// ===================
+
+// random graphs, every second one gets a universal sink planted
+std::vector<matrix> random_graphs(std::size_t count, int max_n, unsigned seed) {
+    std::mt19937 random(seed);
+    std::vector<matrix> graphs;
+    graphs.reserve(count);
+
+    for (std::size_t k = 0; k < count; k++) {
+        int n = 2 + random() % (max_n - 1);
+        matrix m(n, std::vector<int>(n, 0));
+
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) { m[i][j] = i != j && random() % 2; }
+        }
+
+        if (k % 2) {
+            int sink = random() % n;
+            for (int i = 0; i < n; i++) {
+                m[i][sink] = i != sink;
+                m[sink][i] = 0;
+            }
+        }
+
+        graphs.push_back(std::move(m));
+    }
+
+    return graphs;
+}
+
+void test_find_universelle_senke_batch(std::size_t count) {
+    std::vector<matrix> graphs = random_graphs(count, 32, 42);
+
+    high_resolution_clock::time_point single_from = high_resolution_clock::now();
+    std::vector<Result> single;
+    single.reserve(count);
+    for (matrix &m : graphs) { single.push_back(find_universelle_senke_efficient(m)); }
+    high_resolution_clock::time_point single_until = high_resolution_clock::now();
+
+    high_resolution_clock::time_point batch_from = high_resolution_clock::now();
+    std::vector<Result> batch = find_universelle_senke_batch(graphs);
+    high_resolution_clock::time_point batch_until = high_resolution_clock::now();
+
+    duration<double, std::milli> single_dauer = single_until - single_from;
+    duration<double, std::milli> batch_dauer = batch_until - batch_from;
+
+    std::size_t mismatches = 0, sinks = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        if (single[i].getVertexIndex() != batch[i].getVertexIndex()) { mismatches++; }
+        if (batch[i].getVertexIndex() != -1) { sinks++; }
+    }
+
+    std::cout << "[batch] " << count << " Graphen, " << sinks << " mit universeller Senke" << std::endl;
+    std::cout << "[single][" << single_dauer.count() << "ms] [batch, " << std::thread::hardware_concurrency() 
+                        << " threads][" << batch_dauer.count() << "ms] Abweichungen: " << mismatches << std::endl;
+    std::cout << "======================================================================" << std::endl;
+}
+
+// the SIMD finder has to agree with find_universelle_senke on index and accesses, on graphs large
+// enough for the vector loops and for several blocks (n > 256) - and every kernel the CPU
+// supports has to add exactly like the scalar one
+void test_find_universelle_senke_simd(std::size_t count) {
+    std::vector<matrix> graphs = random_graphs(count, 600, 11);
+
+    std::size_t mismatches = 0, sinks = 0;
+    for (const matrix &m : graphs) {
+        Result expected = find_universelle_senke(m);
+        Result simd = find_universelle_senke_simd(m);
+        if (simd.getVertexIndex() != expected.getVertexIndex() ||
+            simd.getMatrixAccesses() != expected.getMatrixAccesses()) {
+            mismatches++;
+        }
+        if (expected.getVertexIndex() != -1) { sinks++; }
+    }
+
+    std::vector<add_row_kernel> kernels;
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse2")) { kernels.push_back(add_row_sse2); }
+    if (__builtin_cpu_supports("avx2")) { kernels.push_back(add_row_avx2); }
+#endif
+
+    std::mt19937 random(3);
+    std::size_t kernel_mismatches = 0;
+    for (std::size_t length = 0; length <= 40; length++) {
+        std::vector<int> row(length), deg_in(length);
+        for (std::size_t j = 0; j < length; j++) { row[j] = random() % 2; deg_in[j] = random() % 100; }
+
+        for (add_row_kernel kernel : kernels) {
+            std::vector<int> actual = deg_in, scalar = deg_in;
+            add_row_scalar(row.data(), scalar.data(), length);
+            kernel(row.data(), actual.data(), length);
+            if (actual != scalar) { kernel_mismatches++; }
+        }
+    }
+
+    std::cout << "[simd] " << count << " Graphen (n <= 600), " << sinks << " mit universeller Senke, "
+              << "Abweichungen zu [normal]: " << mismatches << ", " << kernels.size()
+              << " Kernel(s) gegen skalar, Abweichungen: " << kernel_mismatches << std::endl;
     std::cout << "======================================================================" << std::endl;
 }
 
-int main() {
+// every layout and bit width round trips through a file, and a forged header is rejected
+void test_matrix_file(std::size_t count) {
+    std::vector<matrix> graphs = random_graphs(count, 200, 7);
+    const std::string path = "test_matrix.bin";
+
+    const MatrixFileHeader::Layout layouts[] = {MatrixFileHeader::row_major, MatrixFileHeader::column_major};
+    const std::uint32_t bit_widths[] = {1, 8, 32};
+
+    std::size_t mismatches = 0;
+    for (const matrix &g : graphs) {
+        BitMatrix m(g);
+        Result naive = find_universelle_senke(m);
+        Result efficient = find_universelle_senke_efficient(m);
+
+        for (MatrixFileHeader::Layout layout : layouts) {
+            for (std::uint32_t bit_width : bit_widths) {
+                write_matrix_file(path, m, layout, bit_width);
+                MappedMatrix mapped(path);
+
+                Result mapped_naive = find_universelle_senke(mapped);
+                Result mapped_efficient = find_universelle_senke_efficient(mapped);
+                if (mapped_naive.getVertexIndex() != naive.getVertexIndex() ||
+                    mapped_naive.getMatrixAccesses() != naive.getMatrixAccesses() ||
+                    mapped_efficient.getVertexIndex() != efficient.getVertexIndex() ||
+                    mapped_efficient.getMatrixAccesses() != efficient.getMatrixAccesses()) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    // n = 2^61 rows of 8 bytes: n * row_bytes wraps around to 0
+    BitMatrix small(4);
+    write_matrix_file(path, small);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        unsigned char bytes[MatrixFileHeader::encoded_size];
+        file.read(reinterpret_cast<char *>(bytes), sizeof(bytes));
+
+        // little-endian on any machine: n = 4 is 04 00 00 00 00 00 00 00
+        if (bytes[24] != 4 || std::count(bytes + 25, bytes + 32, 0) != 7) { mismatches++; }
+
+        MatrixFileHeader header = MatrixFileHeader::decode(bytes);
+        header.n = std::uint64_t(1) << 61;
+        header.bit_width = 8;
+        header.row_bytes = 8;
+        header.encode(bytes);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    }
+
+    bool rejected = false;
+    try {
+        MappedMatrix forged(path);
+    } catch (const std::runtime_error &) {
+        rejected = true;
+    }
+    std::remove(path.c_str());
+
+    std::cout << "[file] " << count << " Graphen x 2 Layouts x 3 Bitbreiten, Abweichungen: " << mismatches
+              << ", gefälschter Header abgelehnt: " << (rejected ? "ja" : "nein") << std::endl;
+    std::cout << "======================================================================" << std::endl;
+}
+
+// ./main --benchmark [max_n] runs the benchmark suite for n = 10, 100, ..., max_n (default 10000)
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        run_benchmarks(argc > 2 ? std::stoul(argv[2]) : 10000);
+        return 0;
+    }
+
     matrix adjacent_matrix = {
         {0, 1, 1, 0, 0},
         {0, 0, 1, 0, 0},
@@ -193,4 +1294,61 @@ int main() {
     test_find_universelle_senke(adjacent_matrix_hard);
     test_find_universelle_senke(adjacent_matrix_best);
     test_find_universelle_senke(adjacent_matrix_worst);
+
+    // evaluated by the compiler, there is nothing left to do at run-time
+    constexpr fixed_matrix<5> fixed_matrix_best = {{
+        {0, 0, 0, 0, 0},
+        {1, 0, 1, 1, 0},
+        {1, 0, 0, 1, 0},
+        {1, 0, 1, 0, 1},
+        {1, 1, 1, 0, 0}
+    }};
+
+    constexpr fixed_matrix<5> fixed_matrix_worst = {{
+        {0, 1, 0, 0, 1},
+        {0, 0, 0, 1, 1},
+        {0, 1, 0, 0, 1},
+        {1, 0, 1, 0, 1},
+        {0, 0, 0, 1, 1}
+    }};
+
+    constexpr Result fixed_senke_best = find_universelle_senke_efficient(fixed_matrix_best);
+    static_assert(fixed_senke_best.getVertexIndex() == 0, "vertex 0 is the universal sink");
+    static_assert(find_universelle_senke_efficient(fixed_matrix_worst).getVertexIndex() == -1, "there is no sink");
+    static_assert(find_universelle_senke(fixed_matrix_best).getVertexIndex() == 0, "naive and efficient agree");
+
+    std::cout << "[constexpr] universelle Senke bei Index: [" << fixed_senke_best.getVertexIndex() << "] "
+                        "mit |Matrixzugriffen| = " << fixed_senke_best.getMatrixAccesses() << " (zur Compile-Zeit)" << std::endl;
+    std::cout << "======================================================================" << std::endl;
+
+    // the very same graphs, one bit per edge
+    BitMatrix bit_matrix_best(adjacent_matrix_best);
+    BitMatrix bit_matrix_worst(adjacent_matrix_worst);
+
+    test_find_universelle_senke(bit_matrix_best);
+    test_find_universelle_senke(bit_matrix_worst);
+
+    // round trip through a matrix file, the graph is queried directly from the mapping
+    const std::string path = "adjacent_matrix_best.bin";
+    write_matrix_file(path, bit_matrix_best);
+    {
+        MappedMatrix mapped_matrix_best(path);
+        test_find_universelle_senke(mapped_matrix_best);
+    }
+    std::remove(path.c_str());
+    test_matrix_file(200);
+    test_find_universelle_senke_simd(100);
+
+    // the sparse representation answers the same questions
+    SparseGraph sparse_graph_hard(adjacent_matrix_hard);
+    test_find_universelle_senke(sparse_graph_hard);
+    std::cout << "[sparse] universelle Senke bei Index: [" 
+                        << find_universelle_senke_sparse(sparse_graph_hard).getVertexIndex() << "]" << std::endl;
+    std::cout << "======================================================================" << std::endl;
+
+    test_find_universelle_senke_sparse(1000000);
+
+    test_dynamic_universelle_senke(8, 20000, 32);
+
+    test_find_universelle_senke_batch(50000);
 }
\ No newline at end of file